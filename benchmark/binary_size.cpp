@@ -0,0 +1,65 @@
+#include <observer.h>
+#include <erased_subject.h>
+#include <cstdio>
+#include <utility>
+
+// Measures how the binary size grows with the number of signatures.
+//
+// Each of the signals has its own signature and two connections to lambdas by a connection owner and one
+// by a scoped connection, like the signals of a large application. Build it with BINARY_SIZE_ERASED defined
+// to use pg::erased_subject instead of pg::subject; `make binary_size` builds both and prints their sizes.
+
+namespace
+{
+
+constexpr int signals = 100;
+
+template< int N >
+struct event
+{
+    int value;
+};
+
+#if defined( BINARY_SIZE_ERASED )
+template< typename ...A >
+using subject_type = pg::erased_subject< A... >;
+#else
+template< typename ...A >
+using subject_type = pg::subject< A... >;
+#endif
+
+template< int N >
+int notify_signal( pg::connection_owner &owner )
+{
+    subject_type< const event< N > &, int > s;
+
+    int sum = 0;
+    owner.connect( s, [ &sum ]( const event< N > &e, int i ){ sum += e.value + i; } );
+    owner.connect( s, [ &sum ]( const event< N > &e ){ sum += e.value; } );
+    const auto c = pg::connect( s, [ &sum ]{ ++sum; } );
+
+    s.notify( event< N >{ N }, 1 );
+    return sum;
+}
+
+template< int ...N >
+int notify_signals( std::integer_sequence< int, N... > )
+{
+    pg::connection_owner owner;
+
+    int sum = 0;
+    const int sums[] = { notify_signal< N >( owner )... };
+    for( const int s : sums )
+    {
+        sum += s;
+    }
+    return sum;
+}
+
+}
+
+int main( int /* argc */, char * /* argv */[] )
+{
+    std::printf( "%d signals, notified %d\n", signals, notify_signals( std::make_integer_sequence< int, signals >() ) );
+    return 0;
+}
@@ -0,0 +1,1291 @@
+#include <observer.h>
+#include <concurrent_subject.h>
+#include <queued_subject.h>
+#include <event_bus.h>
+#include <channel.h>
+#include <operators.h>
+#include <awaitable.h>
+#include <fixed_subject.h>
+#include <erased_subject.h>
+#include <recorded_subject.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <new>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+#if defined( __linux__ )
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+// A benchmark suite for the observer library.
+//
+// Usage: suite [--format=text|csv|json] [--repetitions=N] [--min-time=SECONDS] [--filter=TEXT] [--list] [--sizes] [--counters]
+//
+// Each benchmark is calibrated so that one repetition runs for at least the minimal time.
+// The reported times are in nanoseconds per operation, ns/item divides it by the number of
+// observers or notifications that are handled by one operation.
+// --sizes prints the sizes of the library's objects and the heap memory per connection instead of running the benchmarks.
+// --counters adds the cycles, instructions, cache misses and branch misses per operation, which are read from the
+// hardware performance counters with perf_event_open on Linux.
+
+namespace
+{
+
+volatile int count_value = 0;
+volatile int increment   = 1;
+
+// Counts the bytes that are allocated with operator new while counting is enabled, for the size report.
+bool        count_allocations = false;
+std::size_t allocated_bytes   = 0;
+
+// The observers of the multi-threaded benchmarks count per thread so that the threads don't share a cache line.
+thread_local int thread_count = 0;
+
+void increase_count( int value )
+{
+    count_value += value;
+}
+
+struct value_topic : pg::topic< int > {};
+
+#if defined( __cpp_impl_coroutine )
+struct detached_task
+{
+    struct promise_type
+    {
+        detached_task get_return_object() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_never final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {}
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+};
+
+detached_task await_values( pg::subject< int > &s, const bool &stop )
+{
+    while( !stop )
+    {
+        const auto value = co_await pg::next( s );
+        count_value += *value;
+    }
+}
+#endif
+
+struct increase_functor
+{
+    int m_value = 0;
+
+    increase_functor( int value )
+            : m_value( value )
+    {}
+
+    void operator()( int )
+    {
+        count_value += m_value;
+    }
+};
+
+struct increase
+{
+    int m_value = 0;
+
+    increase( int value )
+            : m_value( value )
+    {}
+
+    void increase_count( int )
+    {
+        count_value += m_value;
+    }
+};
+
+enum counter_event
+{
+    cycles,
+    instructions,
+    cache_misses,
+    branch_misses,
+    counter_events
+};
+
+// The hardware performance counters of the thread that runs the benchmarks.
+// The counters are summed over the measurements between reset and totals. The threads that are started by
+// a benchmark are not counted, so the counters of the multi-threaded benchmarks cover only the calling thread.
+class perf_counters
+{
+#if defined( __linux__ )
+    int m_fds[ counter_events ] = { -1, -1, -1, -1 };
+#endif
+    double m_totals[ counter_events ] = {};
+
+public:
+    perf_counters( const perf_counters & ) = delete;
+    perf_counters & operator=( const perf_counters & ) = delete;
+
+    perf_counters() noexcept = default;
+
+    ~perf_counters() noexcept
+    {
+#if defined( __linux__ )
+        for( const int fd : m_fds )
+        {
+            if( fd != -1 )
+            {
+                close( fd );
+            }
+        }
+#endif
+    }
+
+    // Returns false when the counters are not available, for example in a virtual machine without a PMU
+    // or when /proc/sys/kernel/perf_event_paranoid doesn't allow it.
+    bool open() noexcept
+    {
+#if defined( __linux__ )
+        const std::uint64_t configs[ counter_events ] = { PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES, PERF_COUNT_HW_BRANCH_MISSES };
+        for( int i = 0 ; i < counter_events ; ++i )
+        {
+            perf_event_attr attr;
+            std::memset( &attr, 0, sizeof( attr ) );
+            attr.type           = PERF_TYPE_HARDWARE;
+            attr.size           = sizeof( attr );
+            attr.config         = configs[ i ];
+            attr.disabled       = i == 0;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv     = 1;
+            attr.read_format    = PERF_FORMAT_GROUP | PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+            // The counters are one group so that the kernel schedules them together.
+            m_fds[ i ] = static_cast< int >( syscall( SYS_perf_event_open, &attr, 0, -1, i == 0 ? -1 : m_fds[ 0 ], 0 ) );
+            if( m_fds[ i ] == -1 )
+            {
+                return false;
+            }
+        }
+        return true;
+#else
+        return false;
+#endif
+    }
+
+    void start() noexcept
+    {
+#if defined( __linux__ )
+        ioctl( m_fds[ 0 ], PERF_EVENT_IOC_RESET, PERF_IOC_FLAG_GROUP );
+        ioctl( m_fds[ 0 ], PERF_EVENT_IOC_ENABLE, PERF_IOC_FLAG_GROUP );
+#endif
+    }
+
+    void stop() noexcept
+    {
+#if defined( __linux__ )
+        ioctl( m_fds[ 0 ], PERF_EVENT_IOC_DISABLE, PERF_IOC_FLAG_GROUP );
+
+        struct
+        {
+            std::uint64_t count;
+            std::uint64_t time_enabled;
+            std::uint64_t time_running;
+            std::uint64_t values[ counter_events ];
+        } data;
+
+        if( read( m_fds[ 0 ], &data, sizeof( data ) ) == static_cast< ssize_t >( sizeof( data ) ) && data.time_running )
+        {
+            // Scale the counts when the kernel multiplexed the counters with other events.
+            const double scale = static_cast< double >( data.time_enabled ) / static_cast< double >( data.time_running );
+            for( int i = 0 ; i < counter_events ; ++i )
+            {
+                m_totals[ i ] += static_cast< double >( data.values[ i ] ) * scale;
+            }
+        }
+#endif
+    }
+
+    void reset() noexcept
+    {
+        for( double &total : m_totals )
+        {
+            total = 0.0;
+        }
+    }
+
+    const double * totals() const noexcept
+    {
+        return m_totals;
+    }
+};
+
+// The counters that are read around each measurement, nullptr when --counters is not given.
+perf_counters * counters = nullptr;
+
+// Returns the time in nanoseconds that it takes to call the function.
+template< typename F >
+double measure( F &&function )
+{
+    if( counters )
+    {
+        counters->start();
+    }
+
+    const auto start = std::chrono::steady_clock::now();
+    function();
+    const auto stop  = std::chrono::steady_clock::now();
+
+    if( counters )
+    {
+        counters->stop();
+    }
+
+    return std::chrono::duration< double, std::nano >( stop - start ).count();
+}
+
+// Prevents that the compiler optimizes away the operations on the value.
+template< typename T >
+void clobber( T &value )
+{
+#if defined( __GNUC__ )
+    asm volatile( "" : : "r"( &value ) : "memory" );
+#else
+    static void * volatile sink;
+    sink = &value;
+#endif
+}
+
+template< typename F >
+double repeat( const std::size_t iterations, F &&function )
+{
+    return measure( [ & ]
+    {
+        for( std::size_t i = 0 ; i < iterations ; ++i )
+        {
+            function();
+        }
+    } );
+}
+
+struct benchmark
+{
+    std::string                            name;
+    std::size_t                            items;   // The number of observers or notifications handled by one operation.
+    std::function< double( std::size_t ) > run;     // Runs the operation the given number of times and returns the measured time in nanoseconds.
+};
+
+struct result
+{
+    const benchmark *b;
+    std::size_t     iterations;
+    double          min;
+    double          median;
+    double          mean;
+    double          stddev;
+    double          events[ counter_events ];   // The mean of the hardware counters per operation when the counters are read.
+};
+
+template< typename S, typename F >
+benchmark notify_two( std::string name, F function )
+{
+    return { std::move( name ), 2, [ function ]( const std::size_t iterations ) mutable
+    {
+        S s;
+        pg::connection_owner owner;
+        owner.connect( s, function );
+        owner.connect( s, function );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } };
+}
+
+template< typename S >
+benchmark notify_scaling( std::string name, const std::size_t observers )
+{
+    return { std::move( name ) + "/" + std::to_string( observers ), observers, [ observers ]( const std::size_t iterations )
+    {
+        S s;
+        pg::connection_owner owner;
+        for( std::size_t i = 0 ; i < observers ; ++i )
+        {
+            owner.connect( s, [ & ]( int value ){ count_value += value; } );
+        }
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } };
+}
+
+template< typename T >
+benchmark notify_heavy( std::string name, const T value )
+{
+    return { std::move( name ), 2, [ value ]( const std::size_t iterations )
+    {
+        pg::subject< T > s;
+        pg::connection_owner owner;
+        owner.connect( s, []( T v ){ count_value += static_cast< int >( v.size() ); } );
+        owner.connect( s, []( T v ){ count_value += static_cast< int >( v.size() ); } );
+
+        return repeat( iterations, [ & ]{ s.notify( value ); } );
+    } };
+}
+
+std::vector< benchmark > make_benchmarks()
+{
+    std::vector< benchmark > benchmarks;
+
+    // Function call overhead, compare these with the baseline of two direct calls.
+    benchmarks.push_back( { "baseline/free_function", 2, []( const std::size_t iterations )
+    {
+        return repeat( iterations, []{ increase_count( increment ); increase_count( increment ); } );
+    } } );
+
+    benchmarks.push_back( notify_two< pg::subject< int > >( "notify/free_function", increase_count ) );
+    benchmarks.push_back( notify_two< pg::subject< int > >( "notify/std_function", std::function< void( int ) >( []( int value ){ count_value += value; } ) ) );
+    benchmarks.push_back( notify_two< pg::subject< int > >( "notify/lambda", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( notify_two< pg::subject< int > >( "notify/functor", increase_functor( increment ) ) );
+
+    benchmarks.push_back( { "notify/member_function", 2, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::connection_owner owner;
+        increase instance( increment );
+        owner.connect( s, &instance, &increase::increase_count );
+        owner.connect( s, &instance, &increase::increase_count );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // Subject types
+    benchmarks.push_back( { "notify/static_subject", 2, []( const std::size_t iterations )
+    {
+        auto s = pg::make_static_subject( []( int value ){ count_value += value; }, []( int value ){ count_value += value; } );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+    benchmarks.push_back( notify_two< pg::inline_subject< int > >( "notify/inline_subject", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( notify_two< pg::blockable_subject< int > >( "notify/blockable_subject", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( notify_two< pg::concurrent_subject< int > >( "notify/concurrent_subject", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( notify_two< pg::erased_subject< int > >( "notify/erased_subject", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( notify_two< pg::recorded_subject< int > >( "notify/recorded_subject", []( int value ){ count_value += value; } ) );
+    benchmarks.push_back( { "notify/fixed_subject", 2, []( const std::size_t iterations )
+    {
+        pg::fixed_subject< 2, int > s;
+        pg::fixed_connection_owner< 2 > owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+        owner.connect( s, []( int value ){ count_value += value; } );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // Recording the notifications of a subject with two observers in a ring buffer
+    benchmarks.push_back( { "notify/recorded_subject/steady_clock", 2, []( const std::size_t iterations )
+    {
+        pg::event_recorder recorder( 1 << 20 );
+        pg::recorded_subject< int > s;
+        pg::connection_owner owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+        owner.connect( s, []( int value ){ count_value += value; } );
+        recorder.record( s, 1 );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    benchmarks.push_back( { "notify/recorded_subject/numbered", 2, []( const std::size_t iterations )
+    {
+        pg::event_recorder recorder( 1 << 20, nullptr );
+        pg::recorded_subject< int > s;
+        pg::connection_owner owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+        owner.connect( s, []( int value ){ count_value += value; } );
+        recorder.record( s, 1 );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    benchmarks.push_back( { "notify/blockable_subject/blocked", 2, []( const std::size_t iterations )
+    {
+        pg::blockable_subject< int > s;
+        pg::connection_owner owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+        owner.connect( s, []( int value ){ count_value += value; } );
+        s.block();
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // Scaling with the number of observers
+    for( const std::size_t observers : { 1, 10, 1000, 100000 } )
+    {
+        benchmarks.push_back( notify_scaling< pg::subject< int > >( "scaling/subject", observers ) );
+        benchmarks.push_back( notify_scaling< pg::inline_subject< int > >( "scaling/inline_subject", observers ) );
+        benchmarks.push_back( notify_scaling< pg::blockable_subject< int > >( "scaling/blockable_subject", observers ) );
+    }
+
+    // Observers of many subjects that are notified in a random order so that their memory is not cached.
+    benchmarks.push_back( { "notify/cache_cold/65536x4", 4, []( const std::size_t iterations )
+    {
+        const std::size_t subject_count = 65536;
+
+        std::vector< std::unique_ptr< pg::subject< int > > > subjects;
+        std::vector< int >                                   counters( subject_count * 16 );
+        pg::connection_owner                                 owner;
+        for( std::size_t i = 0 ; i < subject_count ; ++i )
+        {
+            subjects.emplace_back( new pg::subject< int > );
+            for( int j = 0 ; j < 4 ; ++j )
+            {
+                int * const counter = &counters[ i * 16 ];
+                owner.connect( *subjects.back(), [ counter ]( int value ){ *counter += value; } );
+            }
+        }
+
+        std::vector< std::size_t > order( subject_count );
+        for( std::size_t i = 0 ; i < subject_count ; ++i )
+        {
+            order[ i ] = i;
+        }
+        std::shuffle( order.begin(), order.end(), std::mt19937( 1003 ) );
+
+        std::size_t next = 0;
+        return repeat( iterations, [ & ]
+        {
+            subjects[ order[ next ] ]->notify( increment );
+            next = ( next + 1 ) % subject_count;
+        } );
+    } } );
+
+    // Observers that are scattered in memory, build with PG_OBSERVER_PREFETCH_DISTANCE to compare prefetching.
+    benchmarks.push_back( { "notify/scattered/100000", 100000, []( const std::size_t iterations )
+    {
+        struct scattered final : pg::observer< int >
+        {
+            int  m_value = 0;
+            char m_payload[ 244 ];
+
+            void disconnect() noexcept override {}
+
+            void notify( int value ) override
+            {
+                count_value += value + m_value;
+            }
+        };
+
+        const std::size_t observers = 100000;
+
+        std::unique_ptr< scattered[] > storage( new scattered[ observers ] );
+        std::vector< std::size_t >     order( observers );
+        for( std::size_t i = 0 ; i < observers ; ++i )
+        {
+            order[ i ] = i;
+        }
+        std::shuffle( order.begin(), order.end(), std::mt19937( 1003 ) );
+
+        pg::subject< int > s;
+        for( const std::size_t i : order )
+        {
+            s.connect( &storage[ i ] );
+        }
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // A chain of four stages as subjects that are connected to each other and as one fused pipeline
+    benchmarks.push_back( { "chain/subjects/4", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int >   s1, s2, s3, s4;
+        pg::connection_owner owner;
+        owner.connect( s1, [ & ]( int value ){ s2.notify( value * 2 ); } );
+        owner.connect( s2, [ & ]( int value ){ if( value > 0 ) s3.notify( value ); } );
+        owner.connect( s3, [ & ]( int value ){ s4.notify( value + 1 ); } );
+        owner.connect( s4, []( int value ){ count_value += value; } );
+
+        return repeat( iterations, [ & ]{ s1.notify( increment ); } );
+    } } );
+
+    benchmarks.push_back( { "chain/pipeline/4", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int >   s;
+        pg::connection_owner owner;
+        owner.connect( s, pg::pipe< int >( pg::map( []( int value ){ return value * 2; } ),
+                                           pg::filter( []( int value ){ return value > 0; } ),
+                                           pg::map( []( int value ){ return value + 1; } ),
+                                           []( int value ){ count_value += value; } ) );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // Heavy argument types
+    benchmarks.push_back( notify_heavy< const std::string & >( "notify/const_string_ref", std::string( 64, 'x' ) ) );
+    benchmarks.push_back( notify_heavy< std::string >( "notify/string_value", std::string( 64, 'x' ) ) );
+    benchmarks.push_back( notify_heavy< std::vector< int > >( "notify/vector_value", std::vector< int >( 64, 1 ) ) );
+
+    // Batches
+    benchmarks.push_back( { "notify_batch/subject/1000x2", 2000, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::connection_owner owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+        owner.connect( s, []( int value ){ count_value += value; } );
+        const std::vector< pg::subject< int >::event_type > events( 1000, pg::subject< int >::event_type( 1 ) );
+
+        return repeat( iterations, [ & ]{ s.notify_batch( events ); } );
+    } } );
+
+    // Routing to one of many topics, compare the event bus with a map of subjects keyed by name
+    benchmarks.push_back( { "event_bus/publish/topic_type", 1, []( const std::size_t iterations )
+    {
+        pg::event_bus bus;
+        auto          c = pg::connect( bus.subject< value_topic >(), []( int value ){ count_value += value; } );
+
+        return repeat( iterations, [ & ]{ bus.publish< value_topic >( increment ); } );
+    } } );
+
+    benchmarks.push_back( { "event_bus/publish/topic_handle", 1, []( const std::size_t iterations )
+    {
+        pg::event_bus                        bus;
+        std::vector< pg::scoped_connection > connections;
+        for( int i = 0 ; i < 256 ; ++i )
+        {
+            const auto t = bus.intern< int >( "topic/" + std::to_string( i ) );
+            connections.push_back( pg::connect( bus.subject( t ), []( int value ){ count_value += value; } ) );
+        }
+        const auto t = bus.intern< int >( "topic/128" );
+
+        return repeat( iterations, [ & ]{ bus.publish( t, increment ); } );
+    } } );
+
+    benchmarks.push_back( { "event_bus/publish/string_map", 1, []( const std::size_t iterations )
+    {
+        std::unordered_map< std::string, std::unique_ptr< pg::subject< int > > > subjects;
+        std::vector< pg::scoped_connection >                                      connections;
+        for( int i = 0 ; i < 256 ; ++i )
+        {
+            auto &s = subjects[ "topic/" + std::to_string( i ) ];
+            s.reset( new pg::subject< int > );
+            connections.push_back( pg::connect( *s, []( int value ){ count_value += value; } ) );
+        }
+        const std::string name = "topic/128";
+
+        return repeat( iterations, [ & ]{ subjects.find( name )->second->notify( increment ); } );
+    } } );
+
+    benchmarks.push_back( { "queued_subject/notify_dispatch", 1, []( const std::size_t iterations )
+    {
+        pg::queued_subject< int > s( 1024 );
+        pg::connection_owner owner;
+        owner.connect( s, []( int value ){ count_value += value; } );
+
+        std::size_t queued = 0;
+        const double time  = repeat( iterations, [ & ]
+        {
+            s.notify( increment );
+            if( ++queued == 1024 )
+            {
+                s.dispatch();
+                queued = 0;
+            }
+        } );
+        return time + measure( [ & ]{ s.dispatch(); } );
+    } } );
+
+    benchmarks.push_back( { "channel/notify_drain", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::channel< int > c( 1024 );
+        auto               connection = pg::connect( s, c.sender() );
+
+        std::size_t pushed = 0;
+        return repeat( iterations, [ & ]
+        {
+            s.notify( increment );
+            if( ++pushed == 1024 )
+            {
+                c.drain( []( int value ){ count_value += value; } );
+                pushed = 0;
+            }
+        } );
+    } } );
+
+#if defined( __cpp_impl_coroutine )
+    // A coroutine that waits for each notification
+    benchmarks.push_back( { "await/notify_resume", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        bool               stop = false;
+        await_values( s, stop );
+
+        const double time = repeat( iterations, [ & ]{ s.notify( increment ); } );
+        stop = true;
+        s.notify( 0 );
+        return time;
+    } } );
+
+#endif
+    // Connecting and disconnecting with 1000 other observers connected to the subject
+    benchmarks.push_back( { "connect_disconnect/connection_owner", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::connection_owner others;
+        for( int i = 0 ; i < 1000 ; ++i )
+        {
+            others.connect( s, []( int value ){ count_value += value; } );
+        }
+
+        pg::connection_owner owner;
+        return repeat( iterations, [ & ]
+        {
+            const auto c = owner.connect( s, []( int value ){ count_value += value; } );
+            owner.disconnect( c );
+        } );
+    } } );
+
+    benchmarks.push_back( { "connect_disconnect/scoped_connection", 1, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::connection_owner others;
+        for( int i = 0 ; i < 1000 ; ++i )
+        {
+            others.connect( s, []( int value ){ count_value += value; } );
+        }
+
+        pg::scoped_connection c;
+        return repeat( iterations, [ & ]
+        {
+            c = pg::connect( s, []( int value ){ count_value += value; } );
+            c.reset();
+        } );
+    } } );
+
+    benchmarks.push_back( { "connect_disconnect/fixed_connection_owner", 1, []( const std::size_t iterations )
+    {
+        pg::fixed_subject< 1001, int > s;
+        pg::fixed_connection_owner< 1000 > others;
+        for( int i = 0 ; i < 1000 ; ++i )
+        {
+            others.connect( s, []( int value ){ count_value += value; } );
+        }
+
+        pg::fixed_connection_owner< 1 > owner;
+        return repeat( iterations, [ & ]
+        {
+            const auto c = owner.connect( s, []( int value ){ count_value += value; } );
+            owner.disconnect( c );
+        } );
+    } } );
+
+    benchmarks.push_back( { "scoped_connection/move", 2, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::scoped_connection a = pg::connect( s, []( int value ){ count_value += value; } );
+        pg::scoped_connection b;
+
+        return repeat( iterations, [ & ]
+        {
+            b = std::move( a );
+            clobber( b );
+            a = std::move( b );
+            clobber( a );
+        } );
+    } } );
+
+    // Teardown of 1000 connections
+    benchmarks.push_back( { "teardown/connection_owner/1000", 1000, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+
+        double time = 0.0;
+        for( std::size_t i = 0 ; i < iterations ; ++i )
+        {
+            std::unique_ptr< pg::connection_owner > owner( new pg::connection_owner );
+            for( int j = 0 ; j < 1000 ; ++j )
+            {
+                owner->connect( s, []( int value ){ count_value += value; } );
+            }
+            time += measure( [ & ]{ owner.reset(); } );
+        }
+        return time;
+    } } );
+
+    benchmarks.push_back( { "teardown/subject/1000", 1000, []( const std::size_t iterations )
+    {
+        pg::connection_owner owner;
+
+        double time = 0.0;
+        for( std::size_t i = 0 ; i < iterations ; ++i )
+        {
+            std::unique_ptr< pg::subject< int > > s( new pg::subject< int > );
+            for( int j = 0 ; j < 1000 ; ++j )
+            {
+                owner.connect( *s, []( int value ){ count_value += value; } );
+            }
+            time += measure( [ & ]{ s.reset(); } );
+        }
+        return time;
+    } } );
+
+    // Teardown of 50000 connections that are spread over 4 subjects
+    benchmarks.push_back( { "teardown/connection_owner/50000x4", 50000, []( const std::size_t iterations )
+    {
+        pg::subject< int > subjects[ 4 ];
+
+        double time = 0.0;
+        for( std::size_t i = 0 ; i < iterations ; ++i )
+        {
+            std::unique_ptr< pg::connection_owner > owner( new pg::connection_owner );
+            for( int j = 0 ; j < 50000 ; ++j )
+            {
+                owner->connect( subjects[ j % 4 ], []( int value ){ count_value += value; } );
+            }
+            time += measure( [ & ]{ owner.reset(); } );
+        }
+        return time;
+    } } );
+
+    benchmarks.push_back( { "teardown/subjects/50000x4", 50000, []( const std::size_t iterations )
+    {
+        pg::connection_owner owner;
+
+        double time = 0.0;
+        for( std::size_t i = 0 ; i < iterations ; ++i )
+        {
+            std::unique_ptr< pg::subject< int > > subjects[ 4 ];
+            for( auto &s : subjects )
+            {
+                s.reset( new pg::subject< int > );
+            }
+            for( int j = 0 ; j < 50000 ; ++j )
+            {
+                owner.connect( *subjects[ j % 4 ], []( int value ){ count_value += value; } );
+            }
+            time += measure( [ & ]
+            {
+                for( auto &s : subjects )
+                {
+                    s.reset();
+                }
+            } );
+        }
+        return time;
+    } } );
+
+    // Many subjects of which the observer counts follow a Zipf distribution, the subject of rank k has 1000 / k observers.
+    // One operation notifies each subject once in a random order.
+    {
+        const std::size_t subject_count = 10000;
+
+        std::size_t observers = 0;
+        for( std::size_t k = 1 ; k <= subject_count ; ++k )
+        {
+            observers += std::max< std::size_t >( 1000 / k, 1 );
+        }
+
+        benchmarks.push_back( { "load/zipf/10000", observers, [ subject_count ]( const std::size_t iterations )
+        {
+            std::vector< std::unique_ptr< pg::subject< int > > > subjects;
+            pg::connection_owner                                 owner;
+            for( std::size_t k = 1 ; k <= subject_count ; ++k )
+            {
+                subjects.emplace_back( new pg::subject< int > );
+                for( std::size_t i = std::max< std::size_t >( 1000 / k, 1 ) ; i > 0 ; --i )
+                {
+                    owner.connect( *subjects.back(), []( int value ){ count_value += value; } );
+                }
+            }
+
+            std::vector< pg::subject< int > * > order;
+            for( const auto &s : subjects )
+            {
+                order.push_back( s.get() );
+            }
+            std::shuffle( order.begin(), order.end(), std::mt19937( 1003 ) );
+
+            return repeat( iterations, [ & ]
+            {
+                for( pg::subject< int > * const s : order )
+                {
+                    s->notify( increment );
+                }
+            } );
+        } } );
+    }
+
+    // Notifying 1000 observers while one of them replaces a random observer by a new one during each notification
+    benchmarks.push_back( { "load/churn/1000", 1000, []( const std::size_t iterations )
+    {
+        pg::subject< int > s;
+        pg::connection_owner owner;
+
+        std::vector< pg::connection_owner::connection > connections;
+        for( int i = 0 ; i < 999 ; ++i )
+        {
+            connections.push_back( owner.connect( s, []( int value ){ count_value += value; } ) );
+        }
+
+        std::mt19937 random( 1003 );
+        owner.connect( s, [ & ]( int )
+        {
+            auto &c = connections[ random() % connections.size() ];
+            owner.disconnect( c );
+            c = owner.connect( s, []( int value ){ count_value += value; } );
+        } );
+
+        return repeat( iterations, [ & ]{ s.notify( increment ); } );
+    } } );
+
+    // Publishers on multiple threads that notify the same concurrent subject with 8 observers.
+    // One operation is one notification by each publisher, the time is the time until all publishers are finished.
+    for( const std::size_t publishers : { 1, 2, 4 } )
+    {
+        benchmarks.push_back( { "threads/publishers/" + std::to_string( publishers ), publishers, [ publishers ]( const std::size_t iterations )
+        {
+            pg::concurrent_subject< int > s;
+            pg::connection_owner owner;
+            for( int i = 0 ; i < 8 ; ++i )
+            {
+                owner.connect( s, []( int value ){ thread_count += value; } );
+            }
+
+            const auto publish = [ & ]
+            {
+                for( std::size_t i = 0 ; i < iterations ; ++i )
+                {
+                    s.notify( increment );
+                }
+            };
+
+            std::atomic< std::size_t > ready{ 0 };
+            std::atomic< bool >        start{ false };
+            std::vector< std::thread > threads;
+            for( std::size_t i = 1 ; i < publishers ; ++i )
+            {
+                threads.emplace_back( [ & ]
+                {
+                    ++ready;
+                    while( !start )
+                    {
+                        std::this_thread::yield();
+                    }
+                    publish();
+                } );
+            }
+            while( ready != publishers - 1 )
+            {
+                std::this_thread::yield();
+            }
+
+            return measure( [ & ]
+            {
+                start = true;
+                publish();
+                for( auto &t : threads )
+                {
+                    t.join();
+                }
+            } );
+        } } );
+    }
+
+    // Notifying a concurrent subject with 100 observers while another thread connects and disconnects an observer
+    benchmarks.push_back( { "threads/churn/100", 100, []( const std::size_t iterations )
+    {
+        pg::concurrent_subject< int > s;
+        pg::connection_owner owner;
+        for( int i = 0 ; i < 100 ; ++i )
+        {
+            owner.connect( s, []( int value ){ thread_count += value; } );
+        }
+
+        std::atomic< bool > stop{ false };
+        std::thread churn( [ & ]
+        {
+            pg::connection_owner churn_owner;
+            while( !stop )
+            {
+                const auto c = churn_owner.connect( s, []( int value ){ thread_count += value; } );
+                churn_owner.disconnect( c );
+                std::this_thread::yield();
+            }
+        } );
+
+        const double time = repeat( iterations, [ & ]{ s.notify( increment ); } );
+        stop = true;
+        churn.join();
+        return time;
+    } } );
+
+    return benchmarks;
+}
+
+result run_benchmark( const benchmark &b, const int repetitions, const double min_time )
+{
+    // Find the number of iterations for which a repetition takes at least the minimal time.
+    const double min_ns    = min_time * 1e9;
+    std::size_t iterations = 1;
+    for( ;; )
+    {
+        const double time = b.run( iterations );
+        if( time >= min_ns || iterations >= 1000000000 )
+        {
+            break;
+        }
+
+        const double factor = time > 0.0 ? min_ns * 1.2 / time : 10.0;
+        iterations          = static_cast< std::size_t >( std::ceil( iterations * std::min( std::max( factor, 2.0 ), 10.0 ) ) );
+    }
+
+    if( counters )
+    {
+        counters->reset();
+    }
+
+    std::vector< double > samples;
+    for( int i = 0 ; i < repetitions ; ++i )
+    {
+        samples.push_back( b.run( iterations ) / static_cast< double >( iterations ) );
+    }
+    std::sort( samples.begin(), samples.end() );
+
+    double sum = 0.0;
+    for( const double s : samples )
+    {
+        sum += s;
+    }
+    const double mean = sum / samples.size();
+
+    double variance = 0.0;
+    for( const double s : samples )
+    {
+        variance += ( s - mean ) * ( s - mean );
+    }
+
+    const std::size_t middle = samples.size() / 2;
+    const double median      = samples.size() % 2 ? samples[ middle ] : ( samples[ middle - 1 ] + samples[ middle ] ) / 2.0;
+
+    result r = { &b, iterations, samples.front(), median, mean, std::sqrt( variance / samples.size() ), {} };
+    if( counters )
+    {
+        const double operations = static_cast< double >( iterations ) * repetitions;
+        for( int i = 0 ; i < counter_events ; ++i )
+        {
+            r.events[ i ] = counters->totals()[ i ] / operations;
+        }
+    }
+    return r;
+}
+
+void print_text_header()
+{
+    std::printf( "%-40s %12s %12s %12s %12s %10s %10s", "benchmark", "iterations", "min ns/op", "median ns/op", "mean ns/op", "stddev", "ns/item" );
+    if( counters )
+    {
+        std::printf( " %12s %12s %14s %15s", "cycles/op", "instr/op", "cache-miss/op", "branch-miss/op" );
+    }
+    std::printf( "\n" );
+}
+
+void print_text( const result &r )
+{
+    std::printf( "%-40s %12zu %12.2f %12.2f %12.2f %10.2f %10.3f",
+                 r.b->name.c_str(), r.iterations, r.min, r.median, r.mean, r.stddev, r.median / r.b->items );
+    if( counters )
+    {
+        std::printf( " %12.1f %12.1f %14.3f %15.3f", r.events[ cycles ], r.events[ instructions ], r.events[ cache_misses ], r.events[ branch_misses ] );
+    }
+    std::printf( "\n" );
+    std::fflush( stdout );
+}
+
+void print_csv_header()
+{
+    std::printf( "name,iterations,min_ns,median_ns,mean_ns,stddev_ns,items,ns_per_item" );
+    if( counters )
+    {
+        std::printf( ",cycles,instructions,cache_misses,branch_misses" );
+    }
+    std::printf( "\n" );
+}
+
+void print_csv( const result &r )
+{
+    std::printf( "%s,%zu,%.3f,%.3f,%.3f,%.3f,%zu,%.4f",
+                 r.b->name.c_str(), r.iterations, r.min, r.median, r.mean, r.stddev, r.b->items, r.median / r.b->items );
+    if( counters )
+    {
+        std::printf( ",%.2f,%.2f,%.4f,%.4f", r.events[ cycles ], r.events[ instructions ], r.events[ cache_misses ], r.events[ branch_misses ] );
+    }
+    std::printf( "\n" );
+}
+
+void print_json( const std::vector< result > &results, const int repetitions, const double min_time )
+{
+    std::printf( "{\n" );
+    std::printf( "  \"context\": {\n" );
+#ifdef __VERSION__
+    std::printf( "    \"compiler\": \"%s\",\n", __VERSION__ );
+#endif
+    std::printf( "    \"cplusplus\": %ld,\n", static_cast< long >( __cplusplus ) );
+    std::printf( "    \"repetitions\": %d,\n", repetitions );
+    std::printf( "    \"min_time\": %g,\n", min_time );
+    std::printf( "    \"counters\": %s\n", counters ? "true" : "false" );
+    std::printf( "  },\n" );
+    std::printf( "  \"benchmarks\": [\n" );
+    for( std::size_t i = 0 ; i < results.size() ; ++i )
+    {
+        const result &r = results[ i ];
+        std::printf( "    { \"name\": \"%s\", \"iterations\": %zu, \"min_ns\": %.3f, \"median_ns\": %.3f, \"mean_ns\": %.3f, \"stddev_ns\": %.3f, \"items\": %zu, \"ns_per_item\": %.4f",
+                     r.b->name.c_str(), r.iterations, r.min, r.median, r.mean, r.stddev, r.b->items, r.median / r.b->items );
+        if( counters )
+        {
+            std::printf( ", \"cycles\": %.2f, \"instructions\": %.2f, \"cache_misses\": %.4f, \"branch_misses\": %.4f",
+                         r.events[ cycles ], r.events[ instructions ], r.events[ cache_misses ], r.events[ branch_misses ] );
+        }
+        std::printf( " }%s\n", i + 1 < results.size() ? "," : "" );
+    }
+    std::printf( "  ]\n" );
+    std::printf( "}\n" );
+}
+
+// Measures the bytes that the function allocates on the heap.
+template< typename F >
+std::size_t heap_bytes( const F &function )
+{
+    allocated_bytes   = 0;
+    count_allocations = true;
+    function();
+    count_allocations = false;
+    return allocated_bytes;
+}
+
+void print_sizes()
+{
+    constexpr std::size_t connections = 10000;
+
+    std::printf( "%-48s %10s\n", "object", "bytes" );
+    std::printf( "%-48s %10zu\n", "pg::subject< int >", sizeof( pg::subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::blockable_subject< int >", sizeof( pg::blockable_subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::inline_subject< int >", sizeof( pg::inline_subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::priority_subject< int >", sizeof( pg::priority_subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::concurrent_subject< int >", sizeof( pg::concurrent_subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::erased_subject< int >", sizeof( pg::erased_subject< int > ) );
+    std::printf( "%-48s %10zu\n", "pg::connection_owner", sizeof( pg::connection_owner ) );
+    std::printf( "%-48s %10zu\n", "pg::connection_owner::connection", sizeof( pg::connection_owner::connection ) );
+    std::printf( "%-48s %10zu\n", "pg::scoped_connection", sizeof( pg::scoped_connection ) );
+    std::printf( "%-48s %10zu\n", "pg::fixed_subject< 16, int >", sizeof( pg::fixed_subject< 16, int > ) );
+    std::printf( "%-48s %10zu\n", "pg::fixed_connection_owner< 16 >", sizeof( pg::fixed_connection_owner< 16 > ) );
+    std::printf( "\n" );
+
+    std::printf( "%-48s %10s\n", "heap memory", "bytes" );
+    std::printf( "%-48s %10zu\n", "pg::subject< int > without observers", heap_bytes( []
+    {
+        pg::subject< int > s;
+        s.notify( 1 );
+    } ) );
+    std::printf( "%-48s %10.1f\n", "per connection, pg::connection_owner", static_cast< double >( heap_bytes( []
+    {
+        pg::subject< int > s;
+        pg::connection_owner owner;
+        for( std::size_t i = 0 ; i < connections ; ++i )
+        {
+            owner.connect( s, []( int value ){ count_value += value; } );
+        }
+    } ) ) / connections );
+    std::printf( "%-48s %10.1f\n", "per connection, pg::scoped_connection", static_cast< double >( heap_bytes( []
+    {
+        pg::subject< int > s;
+        std::vector< pg::scoped_connection > scoped;
+        count_allocations = false;
+        scoped.reserve( connections );
+        count_allocations = true;
+        for( std::size_t i = 0 ; i < connections ; ++i )
+        {
+            scoped.push_back( pg::connect( s, []( int value ){ count_value += value; } ) );
+        }
+    } ) ) / connections );
+    std::printf( "%-48s %10.1f\n", "per connection, pg::fixed_connection_owner", static_cast< double >( heap_bytes( []
+    {
+        count_allocations = false;
+        auto s            = std::make_unique< pg::fixed_subject< connections, int > >();
+        auto owner        = std::make_unique< pg::fixed_connection_owner< connections > >();
+        count_allocations = true;
+        for( std::size_t i = 0 ; i < connections ; ++i )
+        {
+            owner->connect( *s, []( int value ){ count_value += value; } );
+        }
+    } ) ) / connections );
+}
+
+const char * option_value( const char * const arg, const char * const name )
+{
+    const std::size_t length = std::strlen( name );
+    return std::strncmp( arg, name, length ) == 0 && arg[ length ] == '=' ? arg + length + 1 : nullptr;
+}
+
+}
+
+void * operator new( const std::size_t size )
+{
+    if( count_allocations )
+    {
+        allocated_bytes += size;
+    }
+
+    void * const p = std::malloc( size ? size : 1 );
+    if( !p )
+    {
+        throw std::bad_alloc();
+    }
+    return p;
+}
+
+// Not inlined so that the compiler doesn't pair the deletes with the news and warn that the memory is freed with free.
+#if defined( __GNUC__ )
+__attribute__(( noinline ))
+#endif
+void operator delete( void * const p ) noexcept
+{
+    std::free( p );
+}
+
+void operator delete( void * const p, std::size_t ) noexcept
+{
+    ::operator delete( p );
+}
+
+int main( int argc, char * argv[] )
+{
+    std::string format       = "text";
+    std::string filter;
+    int         repetitions  = 5;
+    double      min_time     = 0.1;
+    bool        list         = false;
+    bool        use_counters = false;
+
+    for( int i = 1 ; i < argc ; ++i )
+    {
+        const char * value = nullptr;
+        if( ( value = option_value( argv[ i ], "--format" ) ) )
+        {
+            format = value;
+        }
+        else if( ( value = option_value( argv[ i ], "--repetitions" ) ) )
+        {
+            repetitions = std::max( 1, std::atoi( value ) );
+        }
+        else if( ( value = option_value( argv[ i ], "--min-time" ) ) )
+        {
+            min_time = std::atof( value );
+        }
+        else if( ( value = option_value( argv[ i ], "--filter" ) ) )
+        {
+            filter = value;
+        }
+        else if( std::strcmp( argv[ i ], "--list" ) == 0 )
+        {
+            list = true;
+        }
+        else if( std::strcmp( argv[ i ], "--sizes" ) == 0 )
+        {
+            print_sizes();
+            return 0;
+        }
+        else if( std::strcmp( argv[ i ], "--counters" ) == 0 )
+        {
+            use_counters = true;
+        }
+        else
+        {
+            std::fprintf( stderr, "usage: %s [--format=text|csv|json] [--repetitions=N] [--min-time=SECONDS] [--filter=TEXT] [--list] [--sizes] [--counters]\n", argv[ 0 ] );
+            return 1;
+        }
+    }
+
+    if( format != "text" && format != "csv" && format != "json" )
+    {
+        std::fprintf( stderr, "unknown format '%s'\n", format.c_str() );
+        return 1;
+    }
+
+    perf_counters hardware_counters;
+    if( use_counters && !list )
+    {
+        if( hardware_counters.open() )
+        {
+            counters = &hardware_counters;
+        }
+        else
+        {
+            std::fprintf( stderr, "the hardware performance counters are not available, the benchmarks run without them\n" );
+        }
+    }
+
+    const auto benchmarks = make_benchmarks();
+
+    std::vector< result > results;
+    if( format == "text" && !list )
+    {
+        print_text_header();
+    }
+    else if( format == "csv" && !list )
+    {
+        print_csv_header();
+    }
+
+    for( const auto &b : benchmarks )
+    {
+        if( !filter.empty() && b.name.find( filter ) == std::string::npos )
+        {
+            continue;
+        }
+
+        if( list )
+        {
+            std::printf( "%s\n", b.name.c_str() );
+            continue;
+        }
+
+        results.push_back( run_benchmark( b, repetitions, min_time ) );
+        if( format == "text" )
+        {
+            print_text( results.back() );
+        }
+        else if( format == "csv" )
+        {
+            print_csv( results.back() );
+        }
+    }
+
+    if( format == "json" && !list )
+    {
+        print_json( results, repetitions, min_time );
+    }
+
+    return 0;
+}
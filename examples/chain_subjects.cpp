@@ -1,4 +1,5 @@
 #include <observer.h>
+#include <operators.h>
 #include <iostream>
 
 int main( int /* argc */, char * /* argv */[] )
@@ -22,5 +23,21 @@ int main( int /* argc */, char * /* argv */[] )
     s1.notify();
     s2.notify( "PG1003" );
 
+    // Operators are fused into one observer instead of a subject for each stage
+    pg::subject< int > numbers;
+    pg::subject< int > squares;
+
+    owner.connect( numbers, pg::pipe< int >( pg::filter( []( int i ){ return i % 2 != 0; } ),
+                                             pg::map( []( int i ){ return i * i; } ),
+                                             pg::into( squares ) ) );
+
+    owner.connect( squares, []( int i ){ std::cout << i << std::endl; } );
+
+    // Print "1", "9" and "25"
+    for( int i = 1 ; i <= 5 ; ++i )
+    {
+        numbers.notify( i );
+    }
+
     return 0;
 }
@@ -0,0 +1,225 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+
+#if defined( __cpp_impl_coroutine )
+
+#include <atomic>
+#include <coroutine>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+namespace pg
+{
+
+template< typename ...A >
+class erased_subject;
+
+namespace detail
+{
+
+// The value a waiting coroutine receives; the value itself for one value, a tuple of the values otherwise.
+template< typename ...T >
+struct next_value
+{
+    using type = std::tuple< T... >;
+};
+
+template< typename T >
+struct next_value< T >
+{
+    using type = T;
+};
+
+// An observer that lives in the frame of the waiting coroutine.
+// It connects itself when the coroutine suspends and disconnects itself before it resumes the coroutine.
+// Only the first notification resumes the coroutine, a notification of a concurrent subject on another thread returns.
+template< typename S, typename ...A >
+class next_awaiter final : public observer< A... >
+{
+public:
+    using value_type = typename next_value< typename std::decay< A >::type... >::type;
+
+private:
+    next_awaiter( const next_awaiter & ) = delete;
+    next_awaiter & operator=( const next_awaiter & ) = delete;
+
+    S                           &m_subject;
+    std::coroutine_handle<>     m_handle;
+    std::optional< value_type > m_value;
+    std::atomic< bool >         m_notified{ false };
+    bool                        m_connected = false;
+
+    // The awaiter is destroyed with the coroutine's frame, so it must not be accessed after the coroutine is resumed.
+    template< typename ...V >
+    void resume( V&&... values )
+    {
+        if( m_notified.exchange( true ) )
+        {
+            return;
+        }
+
+        m_value.emplace( std::forward< V >( values )... );
+        m_subject.disconnect( this );
+        m_connected = false;
+        m_handle.resume();
+    }
+
+    virtual void notify( A... args ) override
+    {
+        resume( std::forward< A >( args )... );
+    }
+
+    static void notify_direct( observer< A... > * const o, detail::parameter_t< A >... args )
+    {
+        static_cast< next_awaiter * >( o )->resume( std::forward< detail::parameter_t< A > >( args )... );
+    }
+
+    virtual typename observer< A... >::notify_function get_notify_function() const noexcept override
+    {
+        return &next_awaiter::notify_direct;
+    }
+
+    // The subject is destroyed, the coroutine is resumed without a value.
+    virtual void disconnect() noexcept override
+    {
+        if( m_notified.exchange( true ) )
+        {
+            return;
+        }
+
+        m_connected = false;
+        m_handle.resume();
+    }
+
+public:
+    explicit next_awaiter( S &subject ) noexcept
+            : m_subject( subject )
+    {}
+
+    // Disconnects when the frame of a suspended coroutine is destroyed.
+    ~next_awaiter() noexcept
+    {
+        if( m_connected )
+        {
+            m_subject.disconnect( this );
+        }
+    }
+
+    bool await_ready() const noexcept
+    {
+        return false;
+    }
+
+    // The coroutine isn't suspended when the subject can't connect the awaiter.
+    // The awaiter is not accessed after it is connected since a notification on another thread may resume the coroutine.
+    bool await_suspend( const std::coroutine_handle<> handle ) noexcept
+    {
+        m_handle    = handle;
+        m_connected = true;
+        m_notified.store( false );
+        if( detail::try_connect( m_subject, this ) )
+        {
+            return true;
+        }
+
+        m_connected = false;
+        return false;
+    }
+
+    std::optional< value_type > await_resume() noexcept( std::is_nothrow_move_constructible< value_type >::value )
+    {
+        return std::move( m_value );
+    }
+};
+
+// Deduces the parameters of the awaiter from the connect function of the subject, like observer_type_factory does.
+template< typename S, typename C = decltype( &S::connect ) >
+struct next_awaiter_type
+{
+    static_assert( sizeof( S ) == 0, "pg::next requires a subject with a 'connect( pg::observer< A... > * ) noexcept' member function" );
+};
+
+template< typename S, typename R, typename B, typename ...A >
+struct next_awaiter_type< S, R ( B:: * )( observer< A... > * ) noexcept >
+{
+    using type = next_awaiter< S, A... >;
+};
+
+template< typename S, typename R, typename B, typename ...A >
+struct next_awaiter_type< S, R ( B:: * )( observer< A... > * ) const noexcept >
+{
+    using type = next_awaiter< S, A... >;
+};
+
+}
+
+/**
+ * \brief Returns an awaitable that suspends the coroutine until the subject notifies.
+ *
+ * \param s The subject, for example a pg::subject, a pg::blockable_subject or a pg::concurrent_subject.
+ *
+ * \return An awaitable which co_await results in a std::optional with the notified value,
+ *         or a std::tuple of the values when the subject notifies zero or more than one value.
+ *         The optional is empty when the subject is destroyed while the coroutine waits,
+ *         or when the subject can't connect the awaitable, for example because a pg::fixed_subject is full.
+ *
+ * The awaitable is the observer, it is stored in the frame of the coroutine so that waiting doesn't allocate memory.
+ * It connects to the subject when the coroutine suspends and disconnects before the coroutine is resumed.
+ * This means that the coroutine receives one notification for each wait, notifications that are sent when the coroutine
+ * doesn't wait are missed.
+ * The coroutine is resumed by the notify function of the subject on the thread that notifies.
+ * Destroying a suspended coroutine disconnects the awaitable.
+ *
+ * The values are deduced from the connect function of the subject.
+ * Subjects that pass additional values to their observers, like the pg::dispatch_control of a pg::priority_subject,
+ * deliver a copy of these values too.
+ * When notifications of a pg::concurrent_subject on several threads reach the waiting coroutine at the same time,
+ * only the first of them resumes the coroutine.
+ *
+ * A coroutine that is resumed because its subject is destroyed must not wait for that subject again.
+ *
+ * \note This function is available when the compiler supports C++20 coroutines.
+ */
+template< typename S >
+inline typename detail::next_awaiter_type< S >::type next( S &s ) noexcept
+{
+    return typename detail::next_awaiter_type< S >::type( s );
+}
+
+/**
+ * \brief Waiting for an erased subject is not supported.
+ *
+ * An erased subject passes pointers to the values that are only valid during the notification, the coroutine would keep
+ * these pointers after the notification.
+ */
+template< typename ...A >
+void next( erased_subject< A... > &s ) = delete;
+
+}
+
+#endif
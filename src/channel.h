@@ -0,0 +1,279 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+#include <utility>
+
+namespace pg
+{
+
+template< typename ...A >
+class channel;
+
+/**
+ * \brief A callable that pushes the values of a notification into a pg::channel.
+ *
+ * The sender is small and trivially copyable so that it can be connected with pg::connect and pg::connection_owner::connect.
+ * The lifetime of the channel must exceed the lifetime of the connections of its senders.
+ *
+ * \see pg::channel::sender
+ */
+template< typename ...A >
+class channel_sender
+{
+    channel< A... > * m_channel;
+
+public:
+    explicit channel_sender( channel< A... > &c ) noexcept
+            : m_channel( &c )
+    {}
+
+    void operator()( A... args ) const
+    {
+        m_channel->push( std::forward< A >( args )... );
+    }
+};
+
+/**
+ * \brief A bounded lock-free queue that transfers notifications from the threads that notify to a consumer thread.
+ *
+ * \tparam A The types of the values of the notifications.
+ *
+ * Multiple threads may push notifications at the same time, one thread at a time consumes them with drain.
+ * The memory for the notifications is allocated once at construction, pushing and draining don't allocate or lock.
+ * The values are stored as their decayed types, a channel of const std::string & stores a std::string.
+ * Notifications that are pushed while the channel is full are dropped and counted.
+ *
+ * \code
+ * pg::channel< int > c( 1024 );
+ * auto connection = pg::connect( io_subject, c.sender() );  // Notified on the I/O thread
+ *
+ * c.drain( []( int i ){ process( i ); } );                  // On the processing thread
+ * \endcode
+ */
+template< typename ...A >
+class channel
+{
+    channel( const channel< A... > & ) = delete;
+    channel< A... >& operator=( const channel< A... > & ) = delete;
+
+    using event = std::tuple< typename std::decay< A >::type... >;
+
+    // A cell is free for the push at position p when its sequence is p and holds the notification of position p when
+    // its sequence is p + 1. This is the bounded queue of Dmitry Vyukov with a single consumer.
+    // A cell is empty when constructing its notification threw, the consumer skips it.
+    struct cell
+    {
+        std::atomic< std::size_t >                                               sequence;
+        bool                                                                     empty = false;
+        typename std::aligned_storage< sizeof( event ), alignof( event ) >::type storage;
+    };
+
+    // Publishes the cell that a push claimed, also when constructing the notification throws so that the consumer doesn't wait for it.
+    struct published
+    {
+        cell              &c;
+        const std::size_t position;
+        bool              constructed;
+
+        ~published() noexcept
+        {
+            c.empty = !constructed;
+            c.sequence.store( position + 1, std::memory_order_release );
+        }
+    };
+
+    // Destroys a drained notification and frees its cell for the producers, also when the callback throws.
+    struct drained
+    {
+        channel< A... > &ch;
+        cell            &c;
+
+        ~drained() noexcept
+        {
+            if( !c.empty ) PG_OBSERVER_LIKELY
+            {
+                reinterpret_cast< event * >( &c.storage )->~event();
+            }
+            c.empty = false;
+            c.sequence.store( ch.m_pop_position + ch.m_mask + 1, std::memory_order_release );
+            ++ch.m_pop_position;
+        }
+    };
+
+    static constexpr std::size_t cache_line = 64;
+
+    // The positions of the producers and the consumer are on their own cache lines to avoid false sharing.
+    const std::size_t                                m_mask;
+    std::unique_ptr< cell[] >                        m_cells;
+    alignas( cache_line ) std::atomic< std::size_t > m_push_position{ 0 };
+    alignas( cache_line ) std::atomic< std::size_t > m_dropped{ 0 };
+    alignas( cache_line ) std::size_t                m_pop_position = 0;
+
+    static std::size_t round_up( const std::size_t capacity ) noexcept
+    {
+        std::size_t size = 2;
+        while( size < capacity )
+        {
+            size *= 2;
+        }
+        return size;
+    }
+
+    template< typename F, std::size_t ...I >
+    static void invoke_event( F &function, event &e, std::index_sequence< I... > )
+    {
+        pg::invoke( function, std::move( std::get< I >( e ) )... );
+    }
+
+public:
+    /**
+     * \param capacity The number of notifications that the channel can hold, it is rounded up to a power of 2.
+     */
+    explicit channel( const std::size_t capacity )
+            : m_mask( round_up( capacity ) - 1 )
+            , m_cells( new cell[ m_mask + 1 ] )
+    {
+        for( std::size_t i = 0 ; i <= m_mask ; ++i )
+        {
+            m_cells[ i ].sequence.store( i, std::memory_order_relaxed );
+        }
+    }
+
+    ~channel() noexcept
+    {
+        for( std::size_t p = m_pop_position ; ; ++p )
+        {
+            cell &c = m_cells[ p & m_mask ];
+            if( c.sequence.load( std::memory_order_acquire ) != p + 1 )
+            {
+                break;
+            }
+            if( !c.empty )
+            {
+                reinterpret_cast< event * >( &c.storage )->~event();
+            }
+        }
+    }
+
+    /**
+     * \brief Returns a callable that pushes the values it is called with into this channel.
+     */
+    channel_sender< A... > sender() noexcept
+    {
+        return channel_sender< A... >( *this );
+    }
+
+    /**
+     * \brief Pushes a notification into the channel, may be called from any thread.
+     *
+     * \param args The values of the notification.
+     *
+     * \return Returns false when the channel is full and the notification is dropped.
+     *
+     * When copying or moving a value throws, the exception is passed to the caller and the notification is not delivered.
+     */
+    bool push( A... args )
+    {
+        std::size_t position = m_push_position.load( std::memory_order_relaxed );
+        for( ;; )
+        {
+            cell                &c   = m_cells[ position & m_mask ];
+            const std::size_t   seq  = c.sequence.load( std::memory_order_acquire );
+            const std::intptr_t diff = static_cast< std::intptr_t >( seq ) - static_cast< std::intptr_t >( position );
+            if( diff == 0 )
+            {
+                if( m_push_position.compare_exchange_weak( position, position + 1, std::memory_order_relaxed ) )
+                {
+                    published p{ c, position, false };
+                    new( &c.storage ) event( std::forward< A >( args )... );
+                    p.constructed = true;
+                    return true;
+                }
+            }
+            else if( diff < 0 )
+            {
+                m_dropped.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+            else
+            {
+                position = m_push_position.load( std::memory_order_relaxed );
+            }
+        }
+    }
+
+    /**
+     * \brief Calls the callback for the notifications in the channel, must be called from one thread at a time.
+     *
+     * \param callback A callable that receives the values of a notification as rvalues, it may accept fewer values.
+     *
+     * \return Returns the number of notifications that were passed to the callback.
+     *
+     * At most the capacity of the channel is drained so that producers that keep pushing don't starve the consumer.
+     */
+    template< typename F >
+    std::size_t drain( F&& callback )
+    {
+        std::size_t count = 0;
+        for( std::size_t cells = 0 ; cells <= m_mask ; ++cells )
+        {
+            cell &c = m_cells[ m_pop_position & m_mask ];
+            if( c.sequence.load( std::memory_order_acquire ) != m_pop_position + 1 )
+            {
+                break;
+            }
+
+            const drained d{ *this, c };
+            if( !c.empty ) PG_OBSERVER_LIKELY
+            {
+                invoke_event( callback, *reinterpret_cast< event * >( &c.storage ), std::index_sequence_for< A... >() );
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    /**
+     * \brief Returns the number of notifications that were dropped because the channel was full.
+     */
+    std::size_t dropped() const noexcept
+    {
+        return m_dropped.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * \brief Returns the number of notifications that the channel can hold.
+     */
+    std::size_t capacity() const noexcept
+    {
+        return m_mask + 1;
+    }
+};
+
+}
@@ -0,0 +1,477 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <cstdint>
+
+namespace pg
+{
+
+namespace detail
+{
+
+// The state of a thread that notifies concurrent subjects.
+// generation is the generation in which the outermost notification of the thread started or 0 when the thread doesn't notify.
+// subjects are the subjects of the notifications in progress by nesting level,
+// any is set when the notifications are nested deeper than subjects can hold so that the thread may read any subject.
+struct reader_record
+{
+    static constexpr unsigned max_nesting = 8;
+
+    std::atomic< std::uint64_t > generation{ 0 };
+    std::atomic< const void * >  subjects[ max_nesting ] = {};
+    std::atomic< bool >          any{ false };
+    unsigned                     nesting = 0;
+
+    bool reads( const void * const subject ) const noexcept
+    {
+        if( any.load() )
+        {
+            return true;
+        }
+        for( const auto &s : subjects )
+        {
+            if( s.load() == subject )
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+};
+
+// Keeps track of the threads that notify concurrent subjects so that writers can wait
+// until all notifications that started before a change are finished.
+class reader_registry
+{
+    std::mutex                     m_mutex;
+    std::vector< reader_record * > m_records;
+    std::atomic< std::uint64_t >   m_generation{ 1 };
+
+public:
+    static reader_registry & instance() noexcept
+    {
+        static reader_registry registry;
+        return registry;
+    }
+
+    void add( reader_record * const r )
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_records.push_back( r );
+    }
+
+    void remove( const reader_record * const r ) noexcept
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        m_records.erase( std::find( m_records.begin(), m_records.end(), r ) );
+    }
+
+    std::uint64_t generation() const noexcept
+    {
+        return m_generation.load();
+    }
+
+    // Starts a new generation, notifications that start from now on see the changes made before calling this function.
+    std::uint64_t advance() noexcept
+    {
+        return m_generation.fetch_add( 1 ) + 1;
+    }
+
+    // Returns the generation of the oldest notification in progress that may read the subject.
+    // The generation is loaded before the subjects; a record starts a notification by storing the subject before the generation.
+    std::uint64_t oldest( const void * const subject, const reader_record * const exclude = nullptr ) noexcept
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+
+        std::uint64_t oldest = UINT64_MAX;
+        for( auto r : m_records )
+        {
+            const std::uint64_t g = r->generation.load();
+            if( r != exclude && g && g < oldest && r->reads( subject ) )
+            {
+                oldest = g;
+            }
+        }
+        return oldest;
+    }
+
+    // Waits until the notifications of the subject by other threads that started before the generation have finished.
+    void synchronize( const std::uint64_t generation, const void * const subject, const reader_record * const self ) noexcept
+    {
+        while( oldest( subject, self ) < generation )
+        {
+            std::this_thread::yield();
+        }
+    }
+};
+
+struct thread_reader
+{
+    reader_record record;
+
+    thread_reader()
+    {
+        reader_registry::instance().add( &record );
+    }
+
+    ~thread_reader() noexcept
+    {
+        reader_registry::instance().remove( &record );
+    }
+};
+
+inline reader_record & this_thread_reader()
+{
+    thread_local thread_reader reader;
+    return reader.record;
+}
+
+class read_section
+{
+    reader_record &m_record;
+
+    read_section( const read_section & ) = delete;
+    read_section & operator=( const read_section & ) = delete;
+
+public:
+    // The store that starts a notification is sequentially consistent so that either the writer sees the notification
+    // or the notification sees the snapshot published by the writer.
+    // The outermost notification publishes its subject with the store of the generation.
+    // The stores that end a notification only release since a writer that misses them waits longer.
+    explicit read_section( const void * const subject )
+            : m_record( this_thread_reader() )
+    {
+        const unsigned level = m_record.nesting++;
+        if( level == 0 )
+        {
+            m_record.subjects[ 0 ].store( subject, std::memory_order_relaxed );
+            m_record.generation.store( reader_registry::instance().generation() );
+        }
+        else if( level < reader_record::max_nesting )
+        {
+            m_record.subjects[ level ].store( subject );
+        }
+        else if( level == reader_record::max_nesting )
+        {
+            m_record.any.store( true );
+        }
+    }
+
+    ~read_section() noexcept
+    {
+        const unsigned level = --m_record.nesting;
+        if( level == 0 )
+        {
+            m_record.generation.store( 0, std::memory_order_release );
+        }
+
+        if( level < reader_record::max_nesting )
+        {
+            m_record.subjects[ level ].store( nullptr, std::memory_order_release );
+        }
+        else if( level == reader_record::max_nesting )
+        {
+            m_record.any.store( false, std::memory_order_release );
+        }
+    }
+};
+
+}
+
+/**
+ * \brief A subject that can be notified, connected and disconnected from multiple threads at the same time.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The observers are stored in an immutable snapshot.
+ * A notification reads the snapshot that is current when it starts without taking a lock, so notifications never wait for connects or disconnects.
+ * Connecting and disconnecting publish a new copy of the snapshot.
+ * Snapshots that are replaced are released when the notifications that read them have finished.
+ *
+ * Disconnect waits until the notifications of this subject that started on other threads before the observer was disconnected have finished.
+ * After disconnect returns the observer is no longer notified and can be destroyed.
+ * Notifications of other subjects are not waited for, so observers on different threads that disconnect from the subjects
+ * they are notified by don't wait for each other.
+ * Threads that wait for each other deadlock, for example when observers of the same subject on two threads both disconnect
+ * from it during their notifications, or when a notification of subject a on one thread disconnects from subject b while a
+ * notification of b on another thread disconnects from a.
+ *
+ * \note The connection_owner and scoped_connection that manage the connections to this subject are not thread safe themselves.
+ *
+ * \see pg::subject
+ */
+template< typename ...A >
+class concurrent_subject
+{
+    concurrent_subject( const concurrent_subject< A... > & ) = delete;
+    concurrent_subject< A... >& operator=( const concurrent_subject< A... > & ) = delete;
+
+    struct snapshot
+    {
+        std::vector< detail::pointer_slot< A... > > observers;
+        std::uint64_t                               generation = 0;
+        snapshot                                    *next      = nullptr;
+    };
+
+    std::atomic< snapshot * > m_current{ nullptr };
+    std::mutex                m_mutex;
+    snapshot                  *m_retired = nullptr;
+
+    // Replaces the current snapshot and returns the generation from which the notifications read the new snapshot.
+    std::uint64_t publish( snapshot * const next ) noexcept
+    {
+        auto &registry          = detail::reader_registry::instance();
+        snapshot * const old    = m_current.exchange( next );
+        const std::uint64_t gen = registry.advance();
+
+        if( old )
+        {
+            old->generation = gen;
+            old->next       = m_retired;
+            m_retired       = old;
+        }
+
+        // Release the snapshots that are not read anymore.
+        const std::uint64_t oldest = registry.oldest( this );
+        for( snapshot **r = &m_retired ; *r ; )
+        {
+            if( ( *r )->generation <= oldest )
+            {
+                snapshot * const released = *r;
+                *r                        = released->next;
+                delete released;
+            }
+            else
+            {
+                r = &( *r )->next;
+            }
+        }
+
+        return gen;
+    }
+
+public:
+    concurrent_subject() noexcept = default;
+
+    ~concurrent_subject() noexcept
+    {
+        snapshot * const current = m_current.load();
+        if( current )
+        {
+            for( auto it = current->observers.rbegin() ; it != current->observers.rend() ; ++it )
+            {
+                it->o->disconnect();
+            }
+            delete current;
+        }
+
+        while( m_retired )
+        {
+            snapshot * const released = m_retired;
+            m_retired                 = released->next;
+            delete released;
+        }
+    }
+
+    void connect( observer< A... > * const o ) noexcept
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+
+        const snapshot * const current = m_current.load();
+        auto next                      = new snapshot;
+        if( current )
+        {
+            next->observers.reserve( current->observers.size() + 1 );
+            next->observers = current->observers;
+        }
+        next->observers.emplace_back( o );
+
+        publish( next );
+    }
+
+    void disconnect( const observer< A... > * const o ) noexcept
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+
+        const snapshot * const current = m_current.load();
+        if( !current )
+        {
+            return;
+        }
+
+        const auto &observers = current->observers;
+        const auto it_find    = std::find_if( observers.crbegin(), observers.crend(), [ o ]( const detail::pointer_slot< A... > &s ){ return s.o == o; } );
+        if( it_find == observers.crend() )
+        {
+            return;
+        }
+
+        snapshot * next = nullptr;
+        if( observers.size() > 1 )
+        {
+            next = new snapshot;
+            next->observers.reserve( observers.size() - 1 );
+            next->observers.insert( next->observers.end(), observers.cbegin(), ( it_find + 1 ).base() );
+            next->observers.insert( next->observers.end(), it_find.base(), observers.cend() );
+        }
+
+        const std::uint64_t gen = publish( next );
+
+        // Don't hold the lock while waiting so that observers on other threads are able to connect and disconnect.
+        lock.unlock();
+        auto &self = detail::this_thread_reader();
+        detail::reader_registry::instance().synchronize( gen, this, &self );
+        lock.lock();
+
+        // The notifications in progress on this thread may still read the retired snapshots; remove the observer from these too.
+        if( self.nesting )
+        {
+            for( snapshot * r = m_retired ; r ; r = r->next )
+            {
+                for( auto &s : r->observers )
+                {
+                    if( s.o == o )
+                    {
+                        s.o = nullptr;
+                    }
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Notifies the observers connected to this subject.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     * Observers that are connected or disconnected during the notification by another thread may or may not be notified.
+     */
+    void notify( A... args ) const
+    {
+        if( !m_current.load( std::memory_order_relaxed ) )
+        {
+            return;
+        }
+
+        const detail::read_section section( this );
+
+        const snapshot * const current = m_current.load();
+        if( current )
+        {
+            for( const auto &s : current->observers )
+            {
+                if( s.o ) PG_OBSERVER_LIKELY
+                {
+                    s.notify( s.o, args... );
+                }
+            }
+        }
+    }
+};
+
+
+/**
+ * \brief A concurrent subject with a block count that can be changed from multiple threads.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * This subject has the same blocking interface as pg::blockable_subject so that it can be used with pg::subject_blocker.
+ * The block count is atomic; blocking and unblocking from one thread while other threads notify is safe.
+ * A notification that started before the subject got blocked may still notify the observers.
+ *
+ * \see pg::concurrent_subject pg::blockable_subject
+ */
+template< typename ...A >
+class blockable_concurrent_subject : public concurrent_subject< A... >
+{
+    blockable_concurrent_subject( const blockable_concurrent_subject< A... > & ) = delete;
+    blockable_concurrent_subject< A... >& operator=( const blockable_concurrent_subject< A... > & ) = delete;
+
+    std::atomic< int > m_block_count{ 0 };
+
+public:
+    blockable_concurrent_subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers connected to this subject when not blocked.
+     *
+     * \param args The values passed to the observer's notification function.
+     */
+    void notify( A... args ) const
+    {
+        if( m_block_count.load( std::memory_order_acquire ) == 0 )
+        {
+            concurrent_subject< A... >::notify( std::forward< A >( args )... );
+        }
+    }
+
+    /**
+     * \brief Increases the block count.
+     *
+     * \see blockable_subject::block
+     */
+    void block() noexcept
+    {
+        m_block_count.fetch_add( 1 );
+    }
+
+    /**
+     * \brief Decreases the block count when it is larger than 0.
+     *
+     * \see blockable_subject::unblock
+     */
+    void unblock() noexcept
+    {
+        int count = m_block_count.load();
+        while( count > 0 && !m_block_count.compare_exchange_weak( count, count - 1 ) )
+        {}
+    }
+
+    /**
+     * \brief Overrides the block count when the state differs from the current block state.
+     *
+     * \param block_state The new block state.
+     *
+     * \return Returns the old block state.
+     *
+     * \see blockable_subject::set_block_state
+     */
+    bool set_block_state( const bool block_state ) noexcept
+    {
+        if( block_state )
+        {
+            int expected = 0;
+            return !m_block_count.compare_exchange_strong( expected, 1 );
+        }
+
+        return m_block_count.exchange( 0 ) != 0;
+    }
+};
+
+}
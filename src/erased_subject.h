@@ -0,0 +1,150 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <cstddef>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+namespace pg
+{
+
+template< typename ...A >
+class erased_subject;
+
+namespace detail
+{
+
+// The values of a notification of an erased subject as an array of pointers to the values.
+struct erased_arguments
+{
+    const void * const * values;
+};
+
+// The part of the erased subjects that is the same for all signatures.
+// It is compiled once; the observers, the container of observers and the loop that notifies them are shared by all erased subjects.
+class erased_subject_base : public subject_base< erased_arguments >
+{
+    erased_subject_base( const erased_subject_base & ) = delete;
+    erased_subject_base & operator=( const erased_subject_base & ) = delete;
+
+protected:
+    erased_subject_base() noexcept = default;
+
+    void notify_erased( erased_arguments args ) const
+    {
+        const notification n( *this );
+        notify_slots( observers(), std::false_type(), args );
+    }
+};
+
+// Restores the typed values from the erased arguments and passes them to the callable stored in B.
+// This is the only part of an observer of an erased subject that depends on the signature of the subject.
+template< typename B, typename ...A >
+class erased_observer : public B
+{
+    template< typename T >
+    static typename std::remove_reference< T >::type & argument( const void * const value ) noexcept
+    {
+        return *static_cast< typename std::remove_reference< T >::type * >( const_cast< void * >( value ) );
+    }
+
+    template< std::size_t ...I >
+    void invoke( const erased_arguments args, std::index_sequence< I... > )
+    {
+        B::invoke( argument< A >( args.values[ I ] )... );
+    }
+
+protected:
+    template< typename ...Ab >
+    erased_observer( Ab&&... args ) noexcept
+            : B( std::forward< Ab >( args )... )
+    {}
+
+    void invoke( const erased_arguments args )
+    {
+        invoke( args, std::index_sequence_for< A... >() );
+    }
+
+    // The erased subjects don't store copies of the callables.
+    bool copy_to( void *, std::size_t ) const noexcept
+    {
+        return false;
+    }
+
+    static void invoke_stored( void * const storage, const erased_arguments args )
+    {
+        static_cast< erased_observer * >( storage )->invoke( args );
+    }
+};
+
+// The connections to erased subjects are observers of the shared base of the erased subjects instead of the subject's signature.
+template< template< class, class, class... > class D, typename B, typename ...A >
+struct observer_type_factory< D, B, erased_subject< A... > >
+{
+    using type = D< erased_observer< B, A... >, erased_subject_base, erased_arguments >;
+};
+
+}
+
+/**
+ * \brief A subject that shares its implementation and the implementation of its connections with all other erased subjects.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * A pg::subject and its connections are compiled for each signature; the container of observers, the notify loop,
+ * and the observer classes of pg::connection_owner and pg::scoped_connection.
+ * An erased subject passes its values as an array of pointers to the values, so all of these are compiled once for all erased subjects.
+ * Per signature remain only the notify function that takes the addresses of the values, and per callable the function that
+ * restores and passes the values.
+ * This reduces the binary size and compile times of programs with a lot of different signatures.
+ *
+ * The connect functions, pg::connection_owner and pg::fixed_connection_owner connect to erased subjects like to other subjects.
+ * Observers that are derived from pg::observer< A... > can't be connected to an erased subject.
+ * Unlike pg::subject, the values are not moved into the last observer.
+ *
+ * \see pg::subject
+ */
+template< typename ...A >
+class erased_subject : public detail::erased_subject_base
+{
+public:
+    erased_subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers connected to this subject.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     */
+    void notify( A... args ) const
+    {
+        const void * const values[ sizeof...( A ) + 1 ] = { std::addressof( args )..., nullptr };
+        notify_erased( detail::erased_arguments{ values } );
+    }
+};
+
+}
@@ -0,0 +1,297 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace pg
+{
+
+/**
+ * \brief The base of a topic type of a pg::event_bus.
+ *
+ * \tparam A The types of the values that are published on the topic.
+ *
+ * A topic is defined by deriving an empty type from this class.
+ * \code
+ * struct key_pressed : pg::topic< char > {};
+ * \endcode
+ */
+template< typename ...A >
+struct topic
+{
+    /**
+     * \brief The type of the subject that notifies the observers of the topic.
+     */
+    using subject_type = pg::subject< A... >;
+};
+
+namespace detail
+{
+
+// Type erases the subjects of an event bus so that subjects of different topics can be kept in one array.
+class bus_entry
+{
+public:
+    virtual ~bus_entry() noexcept = default;
+};
+
+template< typename S >
+class bus_subject final : public bus_entry
+{
+public:
+    S subject;
+};
+
+// A unique address for each subject type to check that a topic name is used with the same value types.
+template< typename S >
+struct bus_subject_tag
+{
+    static constexpr char tag = 0;
+};
+
+template< typename S >
+constexpr char bus_subject_tag< S >::tag;
+
+// Returns a number that identifies an event bus in the handles of its named topics, 0 identifies no event bus.
+inline std::uint32_t next_bus_id() noexcept
+{
+    static std::atomic< std::uint32_t > last_id{ 0 };
+
+    std::uint32_t id = last_id.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    while( id == 0 )
+    {
+        id = last_id.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    }
+    return id;
+}
+
+inline std::size_t next_topic_index() noexcept
+{
+    static std::atomic< std::size_t > next{ 0 };
+    return next.fetch_add( 1, std::memory_order_relaxed );
+}
+
+// Each topic type gets an index in the dense array of subjects of the event buses when it is used for the first time.
+template< typename T >
+inline std::size_t topic_index() noexcept
+{
+    static const std::size_t index = next_topic_index();
+    return index;
+}
+
+}
+
+/**
+ * \brief A handle to a named topic of a pg::event_bus.
+ *
+ * \tparam A The types of the values that are published on the topic.
+ *
+ * A handle is only valid for the event bus that returned it.
+ * Publishing with a default constructed handle or a handle of another event bus does nothing.
+ *
+ * \see pg::event_bus::intern
+ */
+template< typename ...A >
+class topic_handle
+{
+    friend class event_bus;
+
+    std::size_t   m_index = ~std::size_t( 0 );
+    std::uint32_t m_bus   = 0;
+
+    topic_handle( const std::size_t index, const std::uint32_t bus ) noexcept
+            : m_index( index )
+            , m_bus( bus )
+    {}
+
+public:
+    topic_handle() noexcept = default;
+};
+
+/**
+ * \brief Routes published values to the observers of topics.
+ *
+ * The subjects of the topics are kept in dense arrays so that publishing is an array access without hashing or map lookups.
+ * Topics are identified as one of the following;
+ * - A type derived from pg::topic which is resolved at compile time.
+ * - A name that is interned once with intern, which returns a pg::topic_handle for publishing.
+ *
+ * A subject of a topic is created when an observer is connected to it for the first time.
+ * Publishing on a topic without a subject does nothing.
+ * The event bus is not thread-safe; like the subjects, it must be used from one thread at a time.
+ */
+class event_bus
+{
+    event_bus( const event_bus & ) = delete;
+    event_bus & operator=( const event_bus & ) = delete;
+
+    struct named_topic
+    {
+        std::unique_ptr< detail::bus_entry > entry;
+        const char *                         tag;
+    };
+
+    std::vector< std::unique_ptr< detail::bus_entry > > m_typed;
+    std::vector< named_topic >                          m_named;
+    std::unordered_map< std::string, std::size_t >      m_names;
+    const std::uint32_t                                 m_id = detail::next_bus_id();
+
+    // The index of the handle's topic or m_named.size() when the handle is not of this event bus.
+    template< typename ...A >
+    std::size_t named_index( const topic_handle< A... > t ) const noexcept
+    {
+        return t.m_bus == m_id && t.m_index < m_named.size() ? t.m_index : m_named.size();
+    }
+
+    template< typename S >
+    static S & get_subject( std::unique_ptr< detail::bus_entry > &entry )
+    {
+        if( !entry )
+        {
+            entry.reset( new detail::bus_subject< S > );
+        }
+        return static_cast< detail::bus_subject< S > * >( entry.get() )->subject;
+    }
+
+    template< typename S >
+    static const S * find_subject( const std::unique_ptr< detail::bus_entry > &entry ) noexcept
+    {
+        return entry ? &static_cast< const detail::bus_subject< S > * >( entry.get() )->subject : nullptr;
+    }
+
+public:
+    event_bus() = default;
+
+    /**
+     * \brief Returns the subject of a topic type to connect observers to, the subject is created when it doesn't exist.
+     *
+     * \tparam T The topic type that derives from pg::topic.
+     */
+    template< typename T >
+    typename T::subject_type & subject()
+    {
+        const std::size_t index = detail::topic_index< T >();
+        if( index >= m_typed.size() )
+        {
+            m_typed.resize( index + 1 );
+        }
+        return get_subject< typename T::subject_type >( m_typed[ index ] );
+    }
+
+    /**
+     * \brief Publishes values on a topic type.
+     *
+     * \tparam T The topic type that derives from pg::topic.
+     *
+     * \param args The values passed to the observers of the topic.
+     */
+    template< typename T, typename ...Ar >
+    void publish( Ar&&... args ) const
+    {
+        const std::size_t index = detail::topic_index< T >();
+        if( index < m_typed.size() )
+        {
+            const auto s = find_subject< typename T::subject_type >( m_typed[ index ] );
+            if( s )
+            {
+                s->notify( std::forward< Ar >( args )... );
+            }
+        }
+    }
+
+    /**
+     * \brief Interns a topic name and returns the handle to use for connecting and publishing.
+     *
+     * \tparam A The types of the values that are published on the topic.
+     *
+     * \param name The name of the topic.
+     *
+     * \return Returns the handle of the topic, interning a name again returns the same handle.
+     *
+     * \throw std::invalid_argument when the name was interned before with other value types.
+     */
+    template< typename ...A >
+    topic_handle< A... > intern( const std::string &name )
+    {
+        const char * const tag = &detail::bus_subject_tag< pg::subject< A... > >::tag;
+
+        const auto it = m_names.find( name );
+        if( it != m_names.end() )
+        {
+            if( m_named[ it->second ].tag != tag )
+            {
+                throw std::invalid_argument( "pg::event_bus: topic '" + name + "' was interned with other value types" );
+            }
+            return topic_handle< A... >( it->second, m_id );
+        }
+
+        m_named.push_back( named_topic{ nullptr, tag } );
+        m_names.emplace( name, m_named.size() - 1 );
+        return topic_handle< A... >( m_named.size() - 1, m_id );
+    }
+
+    /**
+     * \brief Returns the subject of a named topic to connect observers to, the subject is created when it doesn't exist.
+     *
+     * \param t The handle of the topic that is returned by intern.
+     *
+     * \throw std::invalid_argument when the handle is default constructed or of another event bus.
+     */
+    template< typename ...A >
+    pg::subject< A... > & subject( const topic_handle< A... > t )
+    {
+        const std::size_t index = named_index( t );
+        if( index == m_named.size() )
+        {
+            throw std::invalid_argument( "pg::event_bus: the topic handle is not of this event bus" );
+        }
+        return get_subject< pg::subject< A... > >( m_named[ index ].entry );
+    }
+
+    /**
+     * \brief Publishes values on a named topic.
+     *
+     * \param t    The handle of the topic that is returned by intern.
+     * \param args The values passed to the observers of the topic.
+     */
+    template< typename ...A, typename ...Ar >
+    void publish( const topic_handle< A... > t, Ar&&... args ) const
+    {
+        const std::size_t index = named_index( t );
+        const auto        s     = index < m_named.size() ? find_subject< pg::subject< A... > >( m_named[ index ].entry ) : nullptr;
+        if( s )
+        {
+            s->notify( std::forward< Ar >( args )... );
+        }
+    }
+};
+
+}
@@ -0,0 +1,521 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <cstddef>
+#include <cstdint>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace pg
+{
+
+/**
+ * \brief A subject with a fixed capacity of observers that never allocates memory.
+ *
+ * \tparam N The maximum number of connected observers.
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The observers are stored in the subject itself.
+ * Connect, disconnect and notify don't allocate memory and don't throw exceptions, except for exceptions thrown by the observers.
+ * Connect returns false when the subject is full.
+ *
+ * Observers that are connected during a notification are notified from the next notification on, like with pg::subject.
+ * Disconnected observers are removed from the subject when the outermost notification returns, so a full subject
+ * can't connect observers during a notification in the place of observers that are disconnected during that notification.
+ */
+template< std::size_t N, typename ...A >
+class fixed_subject
+{
+    static_assert( N > 0, "a fixed subject must be able to connect at least one observer" );
+
+    fixed_subject( const fixed_subject< N, A... > & ) = delete;
+    fixed_subject< N, A... > & operator=( const fixed_subject< N, A... > & ) = delete;
+
+    using slot = detail::pointer_slot< A... >;
+
+    slot        m_observers[ N ];
+    std::size_t m_size       = 0;
+    std::size_t m_tombstones = 0;
+    std::size_t m_notifying  = 0;
+
+    void compact() noexcept
+    {
+        std::size_t index = 0;
+        for( std::size_t i = 0 ; i < m_size ; ++i )
+        {
+            if( m_observers[ i ].o )
+            {
+                m_observers[ i ].o->m_subject_index = index;
+                m_observers[ index++ ]              = m_observers[ i ];
+            }
+        }
+        m_size       = index;
+        m_tombstones = 0;
+    }
+
+    // Trailing disconnected slots are released right away so that a full subject doesn't have to compact
+    // for connections that are made and removed in a last in, first out order.
+    void maybe_compact() noexcept
+    {
+        while( m_tombstones && !m_observers[ m_size - 1 ].o )
+        {
+            --m_size;
+            --m_tombstones;
+        }
+
+        if( m_tombstones > m_size / 2 )
+        {
+            compact();
+        }
+    }
+
+    slot * find_slot( const observer< A... > * const o ) noexcept
+    {
+        const auto index = o->m_subject_index;
+        if( index < m_size && m_observers[ index ].o == o ) PG_OBSERVER_LIKELY
+        {
+            return &m_observers[ index ];
+        }
+
+        // The observer's index belongs to another subject when it is connected to multiple subjects.
+        for( std::size_t i = m_size ; i-- > 0 ; )
+        {
+            if( m_observers[ i ].o == o )
+            {
+                return &m_observers[ i ];
+            }
+        }
+        return nullptr;
+    }
+
+    class notification
+    {
+        fixed_subject< N, A... > &m_subject;
+
+        notification( const notification & ) = delete;
+        notification & operator=( const notification & ) = delete;
+
+    public:
+        notification( const fixed_subject< N, A... > &subject ) noexcept
+                : m_subject( const_cast< fixed_subject< N, A... > & >( subject ) )
+        {
+            ++m_subject.m_notifying;
+        }
+
+        ~notification() noexcept
+        {
+            if( --m_subject.m_notifying == 0 )
+            {
+                m_subject.maybe_compact();
+            }
+        }
+    };
+
+public:
+    fixed_subject() noexcept = default;
+
+    ~fixed_subject() noexcept
+    {
+        for( std::size_t i = m_size ; i-- > 0 ; )
+        {
+            if( m_observers[ i ].o )
+            {
+                m_observers[ i ].o->disconnect();
+            }
+        }
+    }
+
+    /**
+     * \brief Connects an observer.
+     *
+     * \param o The observer.
+     *
+     * \return Returns false when the subject is full, true otherwise.
+     */
+    bool connect( observer< A... > * const o ) noexcept
+    {
+        if( m_size == N )
+        {
+            if( m_notifying || m_tombstones == 0 )
+            {
+                return false;
+            }
+            compact();
+        }
+
+        o->m_subject_index     = m_size;
+        m_observers[ m_size++ ] = slot( o );
+        return true;
+    }
+
+    void disconnect( const observer< A... > * const o ) noexcept
+    {
+        slot * const s = find_slot( o );
+        if( s )
+        {
+            s->o = nullptr;
+            ++m_tombstones;
+            if( !m_notifying )
+            {
+                maybe_compact();
+            }
+        }
+    }
+
+    /**
+     * \brief Disconnects an observer without compacting the observers, see pg::subject::mark_disconnected.
+     */
+    void mark_disconnected( const observer< A... > * const o ) noexcept
+    {
+        slot * const s = find_slot( o );
+        if( s )
+        {
+            s->o = nullptr;
+            ++m_tombstones;
+        }
+    }
+
+    /**
+     * \brief Compacts the observers after observers were disconnected with mark_disconnected.
+     */
+    void sweep() noexcept
+    {
+        if( !m_notifying )
+        {
+            maybe_compact();
+        }
+    }
+
+    /**
+     * \brief Blocks or unblocks the notifications of one observer, see pg::subject::set_observer_block_state.
+     */
+    bool set_observer_block_state( const observer< A... > * const o, const bool state ) noexcept
+    {
+        slot * const s = find_slot( o );
+        if( !s )
+        {
+            return false;
+        }
+
+        const bool previous = s->blocked();
+        if( previous != state )
+        {
+            s->set_blocked( state );
+        }
+        return previous;
+    }
+
+    /**
+     * \brief Notifies the observers connected to this subject.
+     *
+     * \param args The values passed to the observer's notification function.
+     */
+    void notify( A... args ) const
+    {
+        const notification n( *this );
+        detail::notify_slots( detail::slot_range< slot >( m_observers, m_observers + m_size ), detail::has_reference_parameters< A... >(), args... );
+    }
+
+    /**
+     * \brief Returns the number of connected observers.
+     */
+    std::size_t observer_count() const noexcept
+    {
+        return m_size - m_tombstones;
+    }
+
+    /**
+     * \brief Returns the maximum number of connected observers.
+     */
+    static constexpr std::size_t capacity() noexcept
+    {
+        return N;
+    }
+};
+
+/**
+ * \brief A connection owner with a fixed capacity of connections that never allocates memory.
+ *
+ * \tparam N        The maximum number of connections.
+ * \tparam NodeSize The size in bytes of the storage of one connection.
+ *
+ * The observers of the connections are stored in the connection owner itself, each in a node of NodeSize bytes.
+ * Connecting a callable that doesn't fit in a node is a compile error.
+ * Connect returns a connection that converts to false when the connection owner or the subject is full.
+ *
+ * Connecting, disconnecting and destroying a fixed_connection_owner don't allocate memory when its subjects don't allocate,
+ * for example when the subjects are pg::fixed_subject.
+ *
+ * \see pg::connection_owner
+ */
+template< std::size_t N, std::size_t NodeSize = 64 >
+class fixed_connection_owner
+{
+    static_assert( N > 0, "a fixed connection owner must be able to own at least one connection" );
+
+    using abstract_observer = detail::apex_observer;
+
+    template< typename O, typename B, typename S, typename ...Ao >
+    friend class detail::owner_observer;
+
+    template< typename B, typename S, typename ...Ao >
+    using owner_observer = detail::owner_observer< fixed_connection_owner, B, S, Ao... >;
+
+    fixed_connection_owner( const fixed_connection_owner & ) = delete;
+    fixed_connection_owner & operator=( const fixed_connection_owner & ) = delete;
+
+    using node = typename std::aligned_storage< NodeSize, alignof( std::max_align_t ) >::type;
+
+    node                m_nodes[ N ];
+    abstract_observer * m_observers[ N ]   = {};
+    std::uint32_t       m_generations[ N ] = {};
+    std::uint32_t       m_free[ N ];
+    std::size_t         m_free_count = N;
+    const std::uint32_t m_id         = detail::next_owner_id();
+
+    void release( const std::uint32_t index ) noexcept
+    {
+        m_observers[ index ] = nullptr;
+        if( ++m_generations[ index ] == 0 )
+        {
+            m_generations[ index ] = 1;
+        }
+        m_free[ m_free_count++ ] = index;
+    }
+
+    void remove_observer( const std::uint32_t index ) noexcept
+    {
+        abstract_observer * const o = m_observers[ index ];
+        release( index );
+        o->destroy();
+    }
+
+    template< typename O >
+    void destroy_observer( O * const o ) noexcept
+    {
+        o->~O();
+    }
+
+public:
+    /**
+     * \brief A handle to a subject <--> observer connection of a fixed_connection_owner.
+     *
+     * Like pg::connection_owner::connection the handle is trivially copyable and safe to use after the connection is removed,
+     * handles of other connection owners, also of destroyed connection owners, are ignored.
+     */
+    class connection
+    {
+        friend fixed_connection_owner;
+        std::uint32_t m_owner      = 0;
+        std::uint32_t m_index      = 0;
+        std::uint32_t m_generation = 0;
+
+        connection( const std::uint32_t owner, const std::uint32_t index, const std::uint32_t generation ) noexcept
+                : m_owner( owner )
+                , m_index( index )
+                , m_generation( generation )
+        {}
+
+    public:
+        connection() noexcept = default;
+
+        /**
+         * \brief Returns false when connect failed because the connection owner or the subject was full.
+         */
+        explicit operator bool() const noexcept
+        {
+            return m_owner != 0;
+        }
+    };
+
+private:
+    template< typename O, typename S, typename ...Ab >
+    connection create( S &s, Ab&&... args ) noexcept
+    {
+        static_assert( sizeof( O ) <= NodeSize, "the callable doesn't fit in a node of the fixed connection owner, increase NodeSize" );
+        static_assert( alignof( O ) <= alignof( node ), "the alignment of the callable is larger than the alignment of the nodes" );
+
+        if( m_free_count == 0 )
+        {
+            return connection();
+        }
+
+        const std::uint32_t index = m_free[ --m_free_count ];
+        O * const o               = new( &m_nodes[ index ] ) O( *this, s, std::forward< Ab >( args )... );
+        o->index                  = index;
+        if( !detail::try_connect( s, o ) )
+        {
+            o->~O();
+            m_free[ m_free_count++ ] = index;
+            return connection();
+        }
+
+        m_observers[ index ] = o;
+        return connection( m_id, index, m_generations[ index ] );
+    }
+
+    abstract_observer * find_observer( const connection c ) const noexcept
+    {
+        return c.m_owner == m_id && m_generations[ c.m_index ] == c.m_generation ? m_observers[ c.m_index ] : nullptr;
+    }
+
+public:
+    fixed_connection_owner() noexcept
+    {
+        for( std::size_t i = 0 ; i < N ; ++i )
+        {
+            m_free[ i ] = static_cast< std::uint32_t >( N - 1 - i );
+        }
+    }
+
+    // The observers are removed from their subjects in two passes like in pg::connection_owner.
+    ~fixed_connection_owner() noexcept
+    {
+        for( std::size_t i = N ; i-- > 0 ; )
+        {
+            if( m_observers[ i ] )
+            {
+                m_observers[ i ]->remove_from_subject();
+            }
+        }
+        for( std::size_t i = N ; i-- > 0 ; )
+        {
+            if( m_observers[ i ] )
+            {
+                m_observers[ i ]->sweep_subject();
+                m_observers[ i ]->destroy();
+            }
+        }
+    }
+
+    /**
+     * \brief Connects a member function of an object to a subject.
+     *
+     * \see pg::connection_owner::connect
+     */
+    template< typename S, typename R, typename O, typename ...Ao >
+    connection connect( S &s, O * instance, R ( O::* const function )( Ao... ) ) noexcept
+    {
+        using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< O, R ( O::* )( Ao... ), Ao... >, S >::type;
+        return create< observer_type >( s, instance, function );
+    }
+
+    /**
+     * \overload connect( S & s, O * instance, R( O::* )( Ao... ) function )
+     */
+    template< typename S, typename R, typename O, typename ...Ao >
+    connection connect( S &s, O * instance, R ( O::* const function )( Ao... ) const ) noexcept
+    {
+        using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< O, R ( O::* )( Ao... ) const, Ao... >, S >::type;
+        return create< observer_type >( s, instance, function );
+    }
+
+    /**
+     * \overload connect( S & s, O * instance, R( O::* )( Ao... ) function )
+     */
+    template< typename S, typename R, typename O, typename ...Ao >
+    connection connect( S &s, const O * instance, R ( O::* const function )( Ao... ) const ) noexcept
+    {
+        using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< const O, R ( O::* )( Ao... ) const, Ao... >, S >::type;
+        return create< observer_type >( s, instance, function );
+    }
+
+    /**
+     * \brief Connects a callable to a subject.
+     *
+     * \see pg::connection_owner::connect
+     */
+    template< typename S, typename F >
+    connection connect( S &s, F&& function ) noexcept
+    {
+        using observer_type = typename detail::observer_type_factory< owner_observer, detail::function_observer< F >, S >::type;
+        return create< observer_type >( s, std::forward< F >( function ) );
+    }
+
+    /**
+     * \overload connection connect( S &s, F function ) noexcept
+     */
+    template< typename S, typename R, typename ...Af >
+    connection connect( S &s, R ( * function )( Af... ) ) noexcept
+    {
+        using observer_type = typename detail::observer_type_factory< owner_observer, detail::function_observer< R ( * )( Af... ) >, S >::type;
+        return create< observer_type >( s, std::forward< R ( * )( Af... ) >( function ) );
+    }
+
+    /**
+     * \brief Disconnects the observer from its subject and releases its node.
+     *
+     * \param c The connection handle.
+     */
+    void disconnect( const connection c ) noexcept
+    {
+        abstract_observer * const o = find_observer( c );
+        if( o ) PG_OBSERVER_LIKELY
+        {
+            o->remove_from_subject();
+            o->sweep_subject();
+            release( c.m_index );
+            o->destroy();
+        }
+    }
+
+    /**
+     * \brief Blocks or unblocks the notifications of a connection, see pg::connection_owner::set_block_state.
+     */
+    bool set_block_state( const connection c, const bool state ) noexcept
+    {
+        abstract_observer * const o = find_observer( c );
+        return o ? o->set_block_state( state ) : false;
+    }
+
+    /**
+     * \brief Returns true when the connection exists.
+     *
+     * \param c The connection handle.
+     */
+    bool connected( const connection c ) const noexcept
+    {
+        return find_observer( c ) != nullptr;
+    }
+
+    /**
+     * \brief Returns the number of connections.
+     */
+    std::size_t connection_count() const noexcept
+    {
+        return N - m_free_count;
+    }
+
+    /**
+     * \brief Returns the maximum number of connections.
+     */
+    static constexpr std::size_t capacity() noexcept
+    {
+        return N;
+    }
+};
+
+}
@@ -0,0 +1,302 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+
+namespace pg
+{
+
+/**
+ * \brief A monitor for pg::instrumented_subject that records statistics with lock-free counters.
+ *
+ * The statistics are the number of notifications, the number of notified observers, the largest number of observers
+ * notified by one notification and a histogram of the time that the observers took to handle a notification.
+ * The counters may be read while the subject notifies on other threads.
+ *
+ * A slow observer handler is called when an observer handles a notification longer than a threshold.
+ */
+class subject_statistics
+{
+public:
+    /**
+     * \brief The number of buckets of the histogram.
+     *
+     * Bucket \em i counts the notifications that took [2^i, 2^(i+1)) nanoseconds to handle, bucket 0 includes 0 nanoseconds
+     * and the last bucket includes all durations that are longer.
+     */
+    static constexpr std::size_t buckets = 40;
+
+    /**
+     * \brief A function that is called with the observer and the time it took to handle a notification.
+     */
+    using slow_observer_handler = std::function< void( const void * observer, std::chrono::nanoseconds duration ) >;
+
+private:
+    subject_statistics( const subject_statistics & ) = delete;
+    subject_statistics & operator=( const subject_statistics & ) = delete;
+
+    std::atomic< std::uint64_t > m_notifications{ 0 };
+    std::atomic< std::uint64_t > m_observer_calls{ 0 };
+    std::atomic< std::uint64_t > m_max_observers{ 0 };
+    std::atomic< std::uint64_t > m_histogram[ buckets ] = {};
+    std::chrono::nanoseconds     m_threshold = std::chrono::nanoseconds::max();
+    slow_observer_handler        m_handler;
+
+    static std::size_t bucket( std::uint64_t ns ) noexcept
+    {
+        std::size_t b = 0;
+        while( ns > 1 && b < buckets - 1 )
+        {
+            ns >>= 1;
+            ++b;
+        }
+        return b;
+    }
+
+public:
+    subject_statistics() noexcept = default;
+
+    /**
+     * \brief Sets the function that is called when an observer handles a notification longer than \em threshold.
+     *
+     * \param threshold The duration from which an observer is reported as slow.
+     * \param handler   The function that is called on the thread that notifies, after the observer returned.
+     *
+     * \note Do not set the handler while a subject that uses these statistics notifies.
+     */
+    void set_slow_observer_handler( const std::chrono::nanoseconds threshold, slow_observer_handler handler )
+    {
+        m_threshold = threshold;
+        m_handler   = std::move( handler );
+    }
+
+    /**
+     * \brief Called by the subject before a notification with the number of observers that will be notified.
+     */
+    void on_notify( const std::size_t observers ) noexcept
+    {
+        m_notifications.fetch_add( 1, std::memory_order_relaxed );
+
+        const auto count = static_cast< std::uint64_t >( observers );
+        auto       max   = m_max_observers.load( std::memory_order_relaxed );
+        while( count > max && !m_max_observers.compare_exchange_weak( max, count, std::memory_order_relaxed ) )
+        {}
+    }
+
+    /**
+     * \brief Called by the subject after an observer handled a notification.
+     */
+    void on_observer( const void * const observer, const std::chrono::nanoseconds duration )
+    {
+        const auto ns = duration.count() > 0 ? static_cast< std::uint64_t >( duration.count() ) : 0;
+        m_observer_calls.fetch_add( 1, std::memory_order_relaxed );
+        m_histogram[ bucket( ns ) ].fetch_add( 1, std::memory_order_relaxed );
+
+        if( duration >= m_threshold && m_handler )
+        {
+            m_handler( observer, duration );
+        }
+    }
+
+    /**
+     * \brief Returns the number of notifications.
+     */
+    std::uint64_t notifications() const noexcept
+    {
+        return m_notifications.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * \brief Returns the number of times an observer was notified.
+     */
+    std::uint64_t observer_calls() const noexcept
+    {
+        return m_observer_calls.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * \brief Returns the largest number of observers of one notification.
+     */
+    std::uint64_t max_observers() const noexcept
+    {
+        return m_max_observers.load( std::memory_order_relaxed );
+    }
+
+    /**
+     * \brief Returns the number of observer calls in a bucket of the histogram.
+     *
+     * \see subject_statistics::buckets
+     */
+    std::uint64_t histogram( const std::size_t bucket ) const noexcept
+    {
+        return bucket < buckets ? m_histogram[ bucket ].load( std::memory_order_relaxed ) : 0;
+    }
+
+    /**
+     * \brief Resets all counters to 0.
+     */
+    void reset() noexcept
+    {
+        m_notifications.store( 0, std::memory_order_relaxed );
+        m_observer_calls.store( 0, std::memory_order_relaxed );
+        m_max_observers.store( 0, std::memory_order_relaxed );
+        for( auto &b : m_histogram )
+        {
+            b.store( 0, std::memory_order_relaxed );
+        }
+    }
+};
+
+/**
+ * \brief A subject that reports its notifications and the time its observers take to a monitor.
+ *
+ * \tparam M The type of the monitor, for example pg::subject_statistics.
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The monitor must have the following functions;
+ * - on_notify( std::size_t observers ), called before each notification.
+ * - on_observer( const void * observer, std::chrono::nanoseconds duration ), called after each observer returned.
+ *
+ * The other subjects are not instrumented, they don't pay for the instrumentation of this subject.
+ * Observers are notified in the order they are connected. Values are passed by const reference without moving them into the last observer.
+ *
+ * \see pg::instrumented_blockable_subject
+ */
+template< typename M, typename ...A >
+class instrumented_subject : public detail::subject_base< A... >
+{
+    instrumented_subject( const instrumented_subject< M, A... > & ) = delete;
+    instrumented_subject< M, A... >& operator=( const instrumented_subject< M, A... > & ) = delete;
+
+    M &m_monitor;
+
+public:
+    /**
+     * \param monitor The monitor to which the notifications are reported, its lifetime must exceed the subject's lifetime.
+     *                Multiple subjects may share one monitor.
+     */
+    explicit instrumented_subject( M &monitor ) noexcept
+            : m_monitor( monitor )
+    {}
+
+    /**
+     * \brief Notifies the observers connected to this subject and reports the notification to the monitor.
+     *
+     * \param args The values passed to the observer's notification function.
+     */
+    void notify( A... args ) const
+    {
+        using clock = std::chrono::steady_clock;
+
+        const typename detail::subject_base< A... >::notification n( *this );
+        m_monitor.on_notify( detail::subject_base< A... >::observer_count() );
+
+        for( const auto &s : detail::subject_base< A... >::observers() )
+        {
+            if( s.o && !s.blocked() ) PG_OBSERVER_LIKELY
+            {
+                const void * const o     = s.o;
+                const auto         start = clock::now();
+                s.notify( s.o, args... );
+                m_monitor.on_observer( o, std::chrono::duration_cast< std::chrono::nanoseconds >( clock::now() - start ) );
+            }
+        }
+    }
+
+    /**
+     * \brief Returns the monitor of this subject.
+     */
+    M & monitor() const noexcept
+    {
+        return m_monitor;
+    }
+};
+
+/**
+ * \brief An instrumented subject that can be blocked like pg::blockable_subject.
+ *
+ * Notifications while the subject is blocked are not reported to the monitor.
+ *
+ * \see pg::instrumented_subject pg::subject_blocker
+ */
+template< typename M, typename ...A >
+class instrumented_blockable_subject : public instrumented_subject< M, A... >
+{
+    int m_block_count = 0;
+
+public:
+    using instrumented_subject< M, A... >::instrumented_subject;
+
+    /**
+     * \brief Notifies the observers when the subject is not blocked.
+     *
+     * \param args The values passed to the observer's notification function.
+     */
+    void notify( A... args ) const
+    {
+        if( !m_block_count )
+        {
+            instrumented_subject< M, A... >::notify( std::forward< A >( args )... );
+        }
+    }
+
+    /**
+     * \brief Increases the block count.
+     */
+    void block() noexcept
+    {
+        ++m_block_count;
+    }
+
+    /**
+     * \brief Decreases the block count, the subject is unblocked when the count got 0.
+     */
+    void unblock() noexcept
+    {
+        if( m_block_count > 0 )
+        {
+            --m_block_count;
+        }
+    }
+
+    /**
+     * \brief Overrides the block count when the state differs from the current block state.
+     *
+     * \param block_state The new block state.
+     *
+     * \return Returns the old block state.
+     */
+    bool set_block_state( bool block_state ) noexcept
+    {
+        const bool previous = m_block_count != 0;
+        m_block_count       = block_state ? ( previous ? m_block_count : 1 ) : 0;
+        return previous;
+    }
+};
+
+}
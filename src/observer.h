@@ -24,6 +24,15 @@
 
 #include <vector>
 #include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <new>
+#include <tuple>
+#include <type_traits>
+#include <utility>
 
 #ifdef __has_cpp_attribute
 # if __has_cpp_attribute( nodiscard )
@@ -40,19 +49,112 @@
 # define PG_OBSERVER_LIKELY
 #endif
 
+// Define PG_OBSERVER_PREFETCH_DISTANCE as the number of observers to look ahead to prefetch the observers while notifying.
+// This helps subjects with many observers that are scattered in memory, prefetching is disabled by default.
+#ifndef PG_OBSERVER_PREFETCH_DISTANCE
+# define PG_OBSERVER_PREFETCH_DISTANCE 0
+#endif
+#if PG_OBSERVER_PREFETCH_DISTANCE > 0
+# if defined( __GNUC__ ) || defined( __clang__ )
+#  define PG_OBSERVER_PREFETCH( p ) __builtin_prefetch( p )
+# elif defined( _MSC_VER ) && ( defined( _M_X64 ) || defined( _M_IX86 ) )
+#  include <xmmintrin.h>
+#  define PG_OBSERVER_PREFETCH( p ) _mm_prefetch( reinterpret_cast< const char * >( p ), _MM_HINT_T0 )
+# endif
+#endif
+#ifndef PG_OBSERVER_PREFETCH
+# define PG_OBSERVER_PREFETCH( p )
+#endif
+
 namespace pg
 {
 
+class connection_owner;
+class scoped_connection;
+
+template< std::size_t N, typename ...A >
+class fixed_subject;
+
+template< std::size_t N, std::size_t NodeSize >
+class fixed_connection_owner;
+
 namespace detail
 {
 
 // This base class is to type erase the observers so that different observer types can be collected in a container.
+// Connection owners and scoped connections manage their observers through the private virtual functions, which are
+// part of the observer's vtable, so that their observer nodes have only one vtable pointer.
 class apex_observer
 {
+    friend class pg::connection_owner;
+    friend class pg::scoped_connection;
+
+    template< std::size_t N, std::size_t NodeSize >
+    friend class pg::fixed_connection_owner;
+
+    // Removes the observer from its subject without compacting the subject when the subject supports it.
+    // The subject is compacted by sweep_subject, which is called once after all the observers of a bulk removal are removed.
+    virtual void remove_from_subject() noexcept
+    {}
+
+    virtual void sweep_subject() noexcept
+    {}
+
+    virtual void destroy() noexcept
+    {}
+
+    virtual bool set_block_state( bool ) noexcept
+    {
+        return false;
+    }
+
+    virtual bool is_connected_to( const void * ) const noexcept
+    {
+        return false;
+    }
+
 public:
     virtual ~apex_observer() noexcept = default;
 };
 
+template< typename S, typename ...A >
+class basic_subject_base;
+
+// The type in which a subject passes a value to each of its observers.
+// Values that are cheap to copy are passed by value, other values by const reference so that they are not copied for each observer.
+template< typename T >
+struct parameter
+{
+    using type = typename std::conditional< std::is_trivially_copyable< T >::value && sizeof( T ) <= 2 * sizeof( void * ), T, const T & >::type;
+};
+
+template< typename T >
+struct parameter< T & >
+{
+    using type = T &;
+};
+
+template< typename T >
+struct parameter< T && >
+{
+    using type = T &&;
+};
+
+template< typename T >
+using parameter_t = typename parameter< T >::type;
+
+// True when one of the values is passed by const reference to the observers, in that case the last
+// observer receives the values as rvalues so that it can move them instead of copying.
+template< typename ...A >
+struct has_reference_parameters : std::false_type
+{};
+
+template< typename T, typename ...A >
+struct has_reference_parameters< T, A... >
+        : std::integral_constant< bool, ( !std::is_reference< T >::value && std::is_reference< parameter_t< T > >::value ) ||
+                                        has_reference_parameters< A... >::value >
+{};
+
 }
 
 /**
@@ -65,6 +167,15 @@ public:
 template< typename ...A >
 class observer : public detail::apex_observer
 {
+    template< typename S, typename ...As >
+    friend class detail::basic_subject_base;
+
+    template< std::size_t N, typename ...As >
+    friend class fixed_subject;
+
+    // The position of the observer in the subject's container so that the subject can find it without a search.
+    std::size_t m_subject_index = 0;
+
 public:
     /**
      * \brief Called when the observer is disconnected from the subject.
@@ -79,11 +190,192 @@ public:
      *  \param args The values of the notification. These are defined by this class' template parameters.
      */
     virtual void notify( A... args ) = 0;
+
+    /**
+     * \brief A function that notifies an observer without a virtual function call.
+     *
+     * Values that are not cheap to copy are passed by const reference.
+     */
+    using notify_function = void ( * )( observer< A... > *, detail::parameter_t< A >... );
+
+    /**
+     * \brief Returns the function that subjects call to notify this observer.
+     *
+     * Subjects call this function once when an observer is connected and store the returned function together with the observer.
+     * The default returns a function that calls the virtual notify function.
+     * Observer implementations can return a function that calls their implementation directly to avoid the virtual dispatch at notification.
+     */
+    virtual notify_function get_notify_function() const noexcept
+    {
+        return &observer< A... >::notify_virtual;
+    }
+
+    /**
+     * \brief A function that notifies an observer which callable is stored in the subject.
+     */
+    using inline_notify_function = void ( * )( observer< A... > *, void *, detail::parameter_t< A >... );
+
+    /**
+     * \brief Copies the observer's callable into the storage of a subject.
+     *
+     * \param storage Memory owned by the subject that is aligned for any scalar type.
+     * \param size    The size of \em storage in bytes.
+     *
+     * \return Returns the function that notifies the observer using the copy in \em storage
+     *         or a nullptr when the observer doesn't support this.
+     *
+     * Subjects like pg::inline_subject call this function once when an observer is connected.
+     * The copy is relocated by copying its bytes and is never destroyed.
+     * Observers must only copy callables that are trivially copyable and trivially destructible.
+     * The default returns a nullptr.
+     */
+    virtual inline_notify_function get_inline_notify_function( void * /* storage */, std::size_t /* size */ ) const noexcept
+    {
+        return nullptr;
+    }
+
+    /**
+     * \brief The type of a notification in a batch, see pg::subject::notify_batch.
+     */
+    using event_type = std::tuple< typename std::decay< A >::type... >;
+
+    /**
+     * \brief A function that notifies an observer with a batch of notifications.
+     */
+    using batch_notify_function = void ( * )( observer< A... > *, const event_type *, std::size_t );
+
+    /**
+     * \brief Returns the function that subjects call to notify this observer with a batch of notifications.
+     *
+     * Subjects call this function once for each batch.
+     * The default returns a nullptr, in that case the subject notifies the observer for each notification in the batch.
+     *
+     * \see pg::batch_observer
+     */
+    virtual batch_notify_function get_batch_notify_function() const noexcept
+    {
+        return nullptr;
+    }
+
+private:
+    static void notify_virtual( observer< A... > * const o, detail::parameter_t< A >... args )
+    {
+        o->notify( std::forward< detail::parameter_t< A > >( args )... );
+    }
+};
+
+/**
+ * \brief Interface for observers that receive a batch of notifications at once.
+ *
+ * \tparam A Defines the types of the parameters for the observer's notify function.
+ *
+ * Subjects that notify a batch, like pg::subject::notify_batch, call notify_batch once for the whole batch.
+ * Other notifications are passed to notify_batch as a batch of one notification.
+ */
+template< typename ...A >
+class batch_observer : public observer< A... >
+{
+public:
+    using event_type            = typename observer< A... >::event_type;
+    using batch_notify_function = typename observer< A... >::batch_notify_function;
+
+    /**
+     * \brief The notification function that is called with a batch of notifications.
+     *
+     * \param events The notifications in the order they are notified.
+     * \param count  The number of notifications in \em events.
+     */
+    virtual void notify_batch( const event_type *events, std::size_t count ) = 0;
+
+    void notify( A... args ) override
+    {
+        const event_type e( std::forward< A >( args )... );
+        notify_batch( &e, 1 );
+    }
+
+    batch_notify_function get_batch_notify_function() const noexcept override
+    {
+        return &batch_observer< A... >::notify_batch_virtual;
+    }
+
+private:
+    static void notify_batch_virtual( observer< A... > * const o, const event_type * const events, const std::size_t count )
+    {
+        static_cast< batch_observer< A... > * >( o )->notify_batch( events, count );
+    }
+};
+
+/**
+ * \brief Passed as last value to the observers of a pg::collecting_subject to collect the values that the observers return.
+ *
+ * \tparam C The type of the combiner that folds the returned values.
+ *
+ * The values that the callables and member functions return are collected automatically when they don't accept the sink.
+ * Custom observers call collect with the value they return.
+ */
+template< typename C >
+class result_sink
+{
+    C &m_combiner;
+
+public:
+    explicit result_sink( C &combiner ) noexcept
+            : m_combiner( combiner )
+    {}
+
+    /**
+     * \brief Passes the value to the combiner.
+     */
+    template< typename T >
+    void collect( T&& value )
+    {
+        m_combiner( std::forward< T >( value ) );
+    }
 };
 
 namespace detail
 {
 
+template< typename T >
+struct is_result_sink : std::false_type
+{};
+
+template< typename C >
+struct is_result_sink< result_sink< C > & > : std::true_type
+{};
+
+template< typename ...A >
+struct last_is_result_sink : std::false_type
+{};
+
+template< typename T >
+struct last_is_result_sink< T > : is_result_sink< T >
+{};
+
+template< typename T, typename ...A >
+struct last_is_result_sink< T, A... > : last_is_result_sink< A... >
+{};
+
+template< typename F, typename ...A >
+inline void collect_result( F&& call, std::false_type, A&... )
+{
+    call();
+}
+
+template< typename F, typename ...A >
+inline void collect_result( F&& call, std::true_type, A&... args )
+{
+    std::get< sizeof...( A ) - 1 >( std::forward_as_tuple( args... ) ).collect( call() );
+}
+
+// Calls the observer's callable and passes the value it returns to the result sink when the last value of the notification is one.
+template< typename F, typename ...A >
+inline void invoke_and_collect( F&& call, A&... args )
+{
+    using collect = std::integral_constant< bool, last_is_result_sink< A&... >::value && !std::is_void< decltype( call() ) >::value >;
+    collect_result( std::forward< F >( call ), collect(), args... );
+}
+
 // https://en.cppreference.com/w/cpp/types/remove_reference
 template< typename T > struct remove_reference        { typedef T type; };
 template< typename T > struct remove_reference< T & > { typedef T type; };
@@ -123,298 +415,1957 @@ struct invoke_helper< R ( C:: * )( A... ) const >
     }
 };
 
+// The observers are stored together with their notify function so that notifying does
+// not have to dereference the observer to find the function to call.
 template< typename ...A >
-class subject_base
+struct pointer_slot
 {
-    subject_base( const subject_base< A... > & ) = delete;
-    subject_base< A... >& operator=( const subject_base< A... > & ) = delete;
+    observer< A... >                           *o;
+    typename observer< A... >::notify_function notify;
 
-protected:
-    std::vector< observer< A... > * > m_observers;
+    pointer_slot() noexcept
+            : o( nullptr )
+            , notify( nullptr )
+    {}
 
-    subject_base() noexcept = default;
+    pointer_slot( observer< A... > * const obs ) noexcept
+            : o( obs )
+            , notify( obs->get_notify_function() )
+    {}
 
-    ~subject_base() noexcept
+    // A blocked observer's notify function is replaced by one that does nothing so that notifying doesn't need to test a flag.
+    void set_blocked( const bool blocked ) noexcept
     {
-        for( auto it = m_observers.rbegin() ; it != m_observers.crend() ; ++it )
-        {
-            ( *it )->disconnect();
-        }
+        notify = blocked ? &pointer_slot::notify_blocked : o->get_notify_function();
     }
 
-public:
-    void connect( observer< A... > * const o ) noexcept
+    bool blocked() const noexcept
     {
-        m_observers.push_back( o );
+        return notify == &pointer_slot::notify_blocked;
     }
 
-    void disconnect( const observer< A... > * const o ) noexcept
-    {
-        // Iterate reversed over the m_observers since we expect that observers that
-        // are frequently connected and disconnected resides at the end of the vector.
-        auto it_find = std::find( m_observers.crbegin(), m_observers.crend(), o );
-        if( it_find != m_observers.crend() ) PG_OBSERVER_LIKELY
-        {
-            m_observers.erase( ( ++it_find ).base() );
-        }
-    }
+private:
+    static void notify_blocked( observer< A... > *, parameter_t< A >... ) noexcept
+    {}
 };
 
-}
-
-/**
- * \brief Invokes a callable with the given arguments.
- *
- * \param function A callable such as a free function, lambda, std::function or a functor.
- * \param args     The arguments to forward to \em function.
- *
- * \return Returns the value that the invoked function returned.
- *
- * The advantage this implementation over std::invoke is that the number of parameters that is
- * forwarded to \em function is adjusted when \em function accept less parameters than passed to \em invoke.
- */
-template< typename F, typename ...A >
-inline decltype( auto ) invoke( F&& function, A&&... args )
+// A slot that keeps the priority of its observer, the slots of a subject are ordered from the highest priority to the lowest.
+template< typename ...A >
+struct priority_slot : pointer_slot< A... >
 {
-    return detail::invoke_helper< F >::invoke( std::forward< F >( function ), std::forward< A >( args )... );
-}
+    int priority;
 
-/**
- * \overload inline decltype( auto ) invoke( F&& function, A&&... args )
- */
-template< typename R, typename ...Af, typename ...A >
-inline decltype( auto ) invoke( R ( * function )( Af... ), A&&... args )
-{
-    return detail::invoke_helper< R ( * )( Af... ) >::invoke( std::forward< R ( * )( Af... ) >( function ), std::forward< A >( args )... );
-}
+    priority_slot( observer< A... > * const obs, const int p ) noexcept
+            : pointer_slot< A... >( obs )
+            , priority( p )
+    {}
+};
 
-/**
- * \brief Class that calls the notification function of its observers.
- *
- * \tparam A The types of the values that are passed to the observers notification functions.
- *
- * \see observer
- */
+template< typename S, typename = void >
+struct is_ordered_slot : std::false_type
+{};
+
+template< typename S >
+struct is_ordered_slot< S, decltype( void( std::declval< const S & >().priority ) ) > : std::true_type
+{};
+
+// Stores a copy of the observer's callable in the slot when the observer supports it.
+// Other observers are notified via the notify function that is kept in the storage of the slot.
 template< typename ...A >
-class subject : public detail::subject_base< A... >
+struct inline_slot
 {
-    subject( const subject< A... > & ) = delete;
-    subject< A... >& operator=( const subject< A... > & ) = delete;
+    static constexpr std::size_t storage_size = 4 * sizeof( void * );
 
-public:
-    subject() noexcept = default;
+    alignas( std::max_align_t ) mutable unsigned char storage[ storage_size ];
+    observer< A... >                                  *o;
+    typename observer< A... >::inline_notify_function notify;
 
-    /**
-     * \brief Notifies the observers observers connected to this subject.
-     *
-     * \param args The values passed to the observer's notification function.
-     *
-     * The observers are notified in the order they are connected.
-     */
-    void notify( A... args ) const
+    inline_slot( observer< A... > * const obs ) noexcept
+            : o( obs )
+            , notify( obs->get_inline_notify_function( storage, storage_size ) )
     {
-        for( auto o : detail::subject_base< A... >::m_observers )
+        if( !notify )
         {
-            o->notify( args... );
+            auto const f = obs->get_notify_function();
+            new( storage ) typename observer< A... >::notify_function( f );
+            notify = &inline_slot::notify_stored;
         }
     }
-};
-
-/**
- * \brief Class that calls the notification function of its observers.
- *
- * \tparam A The types of the values that are passed to the observers notification functions.
- *
- * This subject type is blockable.
- * It maintains a block count that is tested before the notification of its observers.
- * This subject blocks notifications when the block count is non-zero.
- *
- * \see observer
- */
-template< typename ...A >
-class blockable_subject : public detail::subject_base< A... >
-{
-    blockable_subject( const blockable_subject< A... > & ) = delete;
-    blockable_subject< A... >& operator=( const blockable_subject< A... > & ) = delete;
-
-    int block_count = 0;
 
-public:
-    blockable_subject() noexcept = default;
-
-    /**
-     * \brief Notifies the observers observers connected to this subject when not blocked.
-     *
-     * \param args The values passed to the observer's notification function.
-     *
-     * The observers are notified in the order they are connected.
-     */
-    void notify( A... args ) const
+    // The storage is kept while blocked; the copy in the storage is the one that is invoked, so only the notify function is restored.
+    void set_blocked( const bool blocked ) noexcept
     {
-        if( !block_count )
+        if( blocked )
         {
-            for( auto o : detail::subject_base< A... >::m_observers )
+            notify = &inline_slot::notify_blocked;
+        }
+        else if( notify == &inline_slot::notify_blocked )
+        {
+            alignas( std::max_align_t ) unsigned char scratch[ storage_size ];
+            notify = o->get_inline_notify_function( scratch, storage_size );
+            if( !notify )
             {
-                o->notify( args... );
+                notify = &inline_slot::notify_stored;
             }
         }
     }
 
-    /**
-     * \brief Blocks the notification of its observers when called.
-     * 
-     * This function can be called multiple times which increases a block count.
-     * You must call \em unblock the same number of times to unblock the subject or call \em set_block_state( false ).
-     *
-     * Notifications are not buffered when the subject is blocked.
-     *
-     * \see blockable_subject::unblock blockable_subject::set_block_state
-     */
+    bool blocked() const noexcept
+    {
+        return notify == &inline_slot::notify_blocked;
+    }
+
+private:
+    static void notify_blocked( observer< A... > *, void *, parameter_t< A >... ) noexcept
+    {}
+
+    static void notify_stored( observer< A... > * const o, void * const storage, parameter_t< A >... args )
+    {
+        ( *static_cast< typename observer< A... >::notify_function * >( storage ) )( o, std::forward< parameter_t< A > >( args )... );
+    }
+};
+
+// A view on the slots of a subject that is empty when the subject has no storage.
+template< typename S >
+class slot_range
+{
+    const S * m_first = nullptr;
+    const S * m_last  = nullptr;
+
+public:
+    slot_range() noexcept = default;
+
+    slot_range( const std::vector< S > &slots ) noexcept
+            : m_first( slots.data() )
+            , m_last( slots.data() + slots.size() )
+    {}
+
+    slot_range( const S * const first, const S * const last ) noexcept
+            : m_first( first )
+            , m_last( last )
+    {}
+
+    const S * begin() const noexcept
+    {
+        return m_first;
+    }
+
+    const S * end() const noexcept
+    {
+        return m_last;
+    }
+
+    std::size_t size() const noexcept
+    {
+        return static_cast< std::size_t >( m_last - m_first );
+    }
+
+    const S & operator[]( const std::size_t index ) const noexcept
+    {
+        return m_first[ index ];
+    }
+};
+
+template< typename S, typename ...A >
+class basic_subject_base
+{
+    basic_subject_base( const basic_subject_base< S, A... > & ) = delete;
+    basic_subject_base< S, A... >& operator=( const basic_subject_base< S, A... > & ) = delete;
+
+    // The storage is allocated when the first observer is connected so that a subject without observers is just one pointer.
+    struct storage
+    {
+        // May contain slots with nullptrs of disconnected observers.
+        std::vector< S > observers;
+
+        // Observers that are connected during a notification are added after the outermost notification returns.
+        // This guarantees that the observers are not reallocated or compacted while the observers are notified.
+        std::vector< S > pending;
+
+        // Disconnected observers leave a nullptr behind so that disconnecting does not have to shift the other observers.
+        // The observers are compacted when more than half of them are these tombstones.
+        std::size_t tombstones = 0;
+        std::size_t notifying  = 0;
+    };
+
+    std::unique_ptr< storage > m_storage;
+
+    storage & get_storage()
+    {
+        if( !m_storage )
+        {
+            m_storage.reset( new storage );
+        }
+        return *m_storage;
+    }
+
+    void compact() noexcept
+    {
+        auto &observers   = m_storage->observers;
+        std::size_t index = 0;
+        for( const auto &s : observers )
+        {
+            if( s.o )
+            {
+                s.o->m_subject_index = index;
+                observers[ index++ ] = s;
+            }
+        }
+        observers.erase( observers.begin() + static_cast< std::ptrdiff_t >( index ), observers.end() );
+        m_storage->tombstones = 0;
+    }
+
+    void maybe_compact() noexcept
+    {
+        if( m_storage->tombstones > m_storage->observers.size() / 2 )
+        {
+            compact();
+        }
+    }
+
+    void insert_pending( std::false_type ) noexcept
+    {
+        m_storage->observers.insert( m_storage->observers.end(), m_storage->pending.cbegin(), m_storage->pending.cend() );
+    }
+
+    void insert_pending( std::true_type ) noexcept
+    {
+        for( const auto &s : m_storage->pending )
+        {
+            insert_ordered( s );
+        }
+    }
+
+    void end_notification() noexcept
+    {
+        if( !m_storage->pending.empty() )
+        {
+            insert_pending( is_ordered_slot< S >() );
+            m_storage->pending.clear();
+        }
+        maybe_compact();
+    }
+
+    // Inserts the slot behind the slots with the same or a higher priority and updates the indices of the slots behind it.
+    void insert_ordered( const S &slot ) noexcept
+    {
+        auto &observers = m_storage->observers;
+        const auto it   = std::upper_bound( observers.begin(), observers.end(), slot, []( const S &a, const S &b ){ return a.priority > b.priority; } );
+        auto index      = static_cast< std::size_t >( it - observers.begin() );
+        observers.insert( it, slot );
+        for( ; index < observers.size() ; ++index )
+        {
+            if( observers[ index ].o )
+            {
+                observers[ index ].o->m_subject_index = index;
+            }
+        }
+    }
+
+    S * find_slot( const observer< A... > * const o ) noexcept
+    {
+        if( !m_storage )
+        {
+            return nullptr;
+        }
+
+        auto &observers  = m_storage->observers;
+        auto &pending    = m_storage->pending;
+        const auto index = o->m_subject_index;
+        const auto size  = observers.size();
+        if( index < size && observers[ index ].o == o ) PG_OBSERVER_LIKELY
+        {
+            return &observers[ index ];
+        }
+        else if( index >= size && index - size < pending.size() && pending[ index - size ].o == o )
+        {
+            return &pending[ index - size ];
+        }
+
+        // The observer's index belongs to another subject when it is connected to multiple subjects.
+        // Iterate reversed over the observers since we expect that observers that
+        // are frequently connected and disconnected resides at the end of the vector.
+        const auto matches = [ o ]( const S &s ){ return s.o == o; };
+        auto it_pending    = std::find_if( pending.rbegin(), pending.rend(), matches );
+        if( it_pending != pending.rend() )
+        {
+            return &*it_pending;
+        }
+        auto it_find = std::find_if( observers.rbegin(), observers.rend(), matches );
+        return it_find != observers.rend() ? &*it_find : nullptr;
+    }
+
+protected:
+    // The slots of the connected observers, may contain slots with nullptrs of disconnected observers.
+    slot_range< S > observers() const noexcept
+    {
+        return m_storage ? slot_range< S >( m_storage->observers ) : slot_range< S >();
+    }
+
+    // Connects the observer of an ordered slot at the position of its priority.
+    void connect_ordered( const S &slot ) noexcept
+    {
+        storage &st             = get_storage();
+        slot.o->m_subject_index = st.observers.size() + st.pending.size();
+        if( st.notifying )
+        {
+            st.pending.push_back( slot );
+        }
+        else
+        {
+            insert_ordered( slot );
+        }
+    }
+
+    // Notifications create an instance of this class while notifying the observers.
+    // Disconnected observers are cleared, but the observers are not moved, until the outermost notification ends.
+    // A subject without storage has no observers that can connect observers during the notification.
+    // The notify functions are const, casting away the constness is fine since only the non-const connect and disconnect defer changes.
+    class notification
+    {
+        basic_subject_base< S, A... > &m_subject;
+
+        notification( const notification & ) = delete;
+        notification & operator=( const notification & ) = delete;
+
+    public:
+        notification( const basic_subject_base< S, A... > &subject ) noexcept
+                : m_subject( const_cast< basic_subject_base< S, A... > & >( subject ) )
+        {
+            if( m_subject.m_storage )
+            {
+                ++m_subject.m_storage->notifying;
+            }
+        }
+
+        ~notification() noexcept
+        {
+            storage * const st = m_subject.m_storage.get();
+            if( st && --st->notifying == 0 && ( !st->pending.empty() || st->tombstones > st->observers.size() / 2 ) )
+            {
+                m_subject.end_notification();
+            }
+        }
+    };
+
+    basic_subject_base() noexcept = default;
+
+    ~basic_subject_base() noexcept
+    {
+        if( !m_storage )
+        {
+            return;
+        }
+
+        for( auto it = m_storage->pending.rbegin() ; it != m_storage->pending.crend() ; ++it )
+        {
+            if( it->o )
+            {
+                it->o->disconnect();
+            }
+        }
+        for( auto it = m_storage->observers.rbegin() ; it != m_storage->observers.crend() ; ++it )
+        {
+            if( it->o )
+            {
+                it->o->disconnect();
+            }
+        }
+    }
+
+public:
+    void connect( observer< A... > * const o ) noexcept
+    {
+        storage &st        = get_storage();
+        o->m_subject_index = st.observers.size() + st.pending.size();
+        if( st.notifying )
+        {
+            st.pending.emplace_back( o );
+        }
+        else
+        {
+            st.observers.emplace_back( o );
+        }
+    }
+
+    /**
+     * \brief Reserves room for the given number of observers.
+     *
+     * \param capacity The number of observers for which memory is allocated at once.
+     *
+     * Reserving avoids growing the container repeatedly when a lot of observers are connected.
+     * During a notification the room is reserved for the observers that are connected when the notification returns.
+     */
+    void reserve( const std::size_t capacity )
+    {
+        storage &st = get_storage();
+        if( st.notifying )
+        {
+            const std::size_t connected = observer_count();
+            st.pending.reserve( st.pending.size() + ( capacity > connected ? capacity - connected : 0 ) );
+        }
+        else
+        {
+            st.observers.reserve( capacity + st.tombstones );
+        }
+    }
+
+    /**
+     * \brief Returns the number of connected observers.
+     */
+    std::size_t observer_count() const noexcept
+    {
+        return m_storage ? m_storage->observers.size() + m_storage->pending.size() - m_storage->tombstones : 0;
+    }
+
+    void disconnect( const observer< A... > * const o ) noexcept
+    {
+        S * const s = find_slot( o );
+        if( s )
+        {
+            s->o = nullptr;
+            ++m_storage->tombstones;
+            if( !m_storage->notifying )
+            {
+                maybe_compact();
+            }
+        }
+    }
+
+    /**
+     * \brief Disconnects an observer without compacting the container of observers.
+     *
+     * \param o The observer.
+     *
+     * This is meant for bulk removals, like the destruction of a connection owner, that disconnect a lot of observers at once.
+     * The observers don't move until sweep is called so that the indices of the other observers stay valid.
+     *
+     * \see sweep
+     */
+    void mark_disconnected( const observer< A... > * const o ) noexcept
+    {
+        S * const s = find_slot( o );
+        if( s )
+        {
+            s->o = nullptr;
+            ++m_storage->tombstones;
+        }
+    }
+
+    /**
+     * \brief Compacts the container of observers after observers were disconnected with mark_disconnected.
+     *
+     * Does nothing during a notification, the container is compacted when the notification returns.
+     */
+    void sweep() noexcept
+    {
+        if( m_storage && !m_storage->notifying )
+        {
+            maybe_compact();
+        }
+    }
+
+    /**
+     * \brief Blocks or unblocks the notifications of one observer.
+     *
+     * \param o     The observer.
+     * \param state Blocks the notifications of the observer when true, unblocks them when false.
+     *
+     * \return Returns the previous block state of the observer, false when the observer is not connected.
+     *
+     * The observer stays connected while it is blocked.
+     * Blocking doesn't cost anything when notifying since a blocked observer is called through a function that does nothing.
+     */
+    bool set_observer_block_state( const observer< A... > * const o, const bool state ) noexcept
+    {
+        S * const s = find_slot( o );
+        if( !s )
+        {
+            return false;
+        }
+
+        const bool previous = s->blocked();
+        if( previous != state )
+        {
+            s->set_blocked( state );
+        }
+        return previous;
+    }
+};
+
+template< typename ...A >
+using subject_base = basic_subject_base< pointer_slot< A... >, A... >;
+
+template< typename ...A >
+using inline_subject_base = basic_subject_base< inline_slot< A... >, A... >;
+
+// Prefetches the observer that is notified PG_OBSERVER_PREFETCH_DISTANCE observers after the observer at index.
+template< typename ...A >
+inline void prefetch_observer( const slot_range< pointer_slot< A... > > &observers, const std::size_t index ) noexcept
+{
+#if PG_OBSERVER_PREFETCH_DISTANCE > 0
+    if( index + PG_OBSERVER_PREFETCH_DISTANCE < observers.size() )
+    {
+        PG_OBSERVER_PREFETCH( observers[ index + PG_OBSERVER_PREFETCH_DISTANCE ].o );
+    }
+#else
+    ( void )observers;
+    ( void )index;
+#endif
+}
+
+template< typename ...A >
+inline void notify_slots( const slot_range< pointer_slot< A... > > &observers, std::false_type, typename std::add_lvalue_reference< A >::type... args )
+{
+    for( std::size_t i = 0 ; i < observers.size() ; ++i )
+    {
+        prefetch_observer( observers, i );
+        const auto &s = observers[ i ];
+        if( s.o ) PG_OBSERVER_LIKELY
+        {
+            s.notify( s.o, args... );
+        }
+    }
+}
+
+// The values are passed by const reference to all observers except for the last one which receives them as rvalues.
+// The last observer is notified with its virtual notify function that takes the values by value so that they can be moved.
+template< typename ...A >
+inline void notify_slots( const slot_range< pointer_slot< A... > > &observers, std::true_type, typename std::add_lvalue_reference< A >::type... args )
+{
+    std::size_t last = observers.size();
+    while( last && ( !observers[ last - 1 ].o || observers[ last - 1 ].blocked() ) )
+    {
+        --last;
+    }
+
+    if( last == 0 )
+    {
+        return;
+    }
+
+    for( std::size_t i = 0 ; i < last - 1 ; ++i )
+    {
+        prefetch_observer( observers, i );
+        const auto &s = observers[ i ];
+        if( s.o ) PG_OBSERVER_LIKELY
+        {
+            s.notify( s.o, args... );
+        }
+    }
+
+    // The last observer can be disconnected or blocked by the observers before it.
+    const auto &s = observers[ last - 1 ];
+    if( s.o && !s.blocked() ) PG_OBSERVER_LIKELY
+    {
+        s.o->notify( std::forward< A >( args )... );
+    }
+}
+
+}
+
+/**
+ * \brief Invokes a callable with the given arguments.
+ *
+ * \param function A callable such as a free function, lambda, std::function or a functor.
+ * \param args     The arguments to forward to \em function.
+ *
+ * \return Returns the value that the invoked function returned.
+ *
+ * The advantage this implementation over std::invoke is that the number of parameters that is
+ * forwarded to \em function is adjusted when \em function accept less parameters than passed to \em invoke.
+ */
+template< typename F, typename ...A >
+inline decltype( auto ) invoke( F&& function, A&&... args )
+{
+    return detail::invoke_helper< F >::invoke( std::forward< F >( function ), std::forward< A >( args )... );
+}
+
+/**
+ * \overload inline decltype( auto ) invoke( F&& function, A&&... args )
+ */
+template< typename R, typename ...Af, typename ...A >
+inline decltype( auto ) invoke( R ( * function )( Af... ), A&&... args )
+{
+    return detail::invoke_helper< R ( * )( Af... ) >::invoke( std::forward< R ( * )( Af... ) >( function ), std::forward< A >( args )... );
+}
+
+/**
+ * \brief Class that calls the notification function of its observers.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * \see observer
+ */
+template< typename ...A >
+class subject : public detail::subject_base< A... >
+{
+    subject( const subject< A... > & ) = delete;
+    subject< A... >& operator=( const subject< A... > & ) = delete;
+
+    template< std::size_t ...I >
+    static void notify_event( const detail::pointer_slot< A... > &s, const typename observer< A... >::event_type &e, std::index_sequence< I... > )
+    {
+        s.notify( s.o, std::get< I >( e )... );
+    }
+
+public:
+    /**
+     * \brief The type of a notification in a batch.
+     */
+    using event_type = typename observer< A... >::event_type;
+
+    subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers observers connected to this subject.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     * Values that are not cheap to copy are passed by const reference to the observers, except for the last observer
+     * which receives them as rvalues so that it can move them.
+     */
+    void notify( A... args ) const
+    {
+        const typename detail::subject_base< A... >::notification n( *this );
+        detail::notify_slots( detail::subject_base< A... >::observers(), detail::has_reference_parameters< A... >(), args... );
+    }
+
+    /**
+     * \brief Notifies the observers connected to this subject with a batch of notifications.
+     *
+     * \param events The values of the notifications.
+     * \param count  The number of notifications in \em events.
+     *
+     * Each observer receives all notifications of the batch before the next observer is notified.
+     * Observers that implement pg::batch_observer receive the batch with one call.
+     * Other observers are notified for each notification in the batch.
+     *
+     * \see observer::get_batch_notify_function
+     */
+    void notify_batch( const event_type * const events, const std::size_t count ) const
+    {
+        const typename detail::subject_base< A... >::notification n( *this );
+        for( const auto &s : detail::subject_base< A... >::observers() )
+        {
+            if( !s.o || s.blocked() )
+            {
+                continue;
+            }
+
+            const auto batch_notify = s.o->get_batch_notify_function();
+            if( batch_notify )
+            {
+                batch_notify( s.o, events, count );
+            }
+            else
+            {
+                for( std::size_t i = 0 ; i < count && s.o ; ++i )
+                {
+                    notify_event( s, events[ i ], std::index_sequence_for< A... >() );
+                }
+            }
+        }
+    }
+
+    /**
+     * \overload void notify_batch( const event_type * const events, const std::size_t count ) const
+     *
+     * \param events A contiguous container of notifications like std::vector, std::array or std::span.
+     */
+    template< typename C >
+    void notify_batch( const C &events ) const
+    {
+        notify_batch( events.data(), events.size() );
+    }
+
+    /**
+     * \brief Notifies the observers observers connected to this subject on multiple threads.
+     *
+     * \param policy Distributes the observers over threads.
+     * \param args   The values passed to the observer's notification function.
+     *
+     * The observers are notified serially like notify when there are less observers than policy.threshold.
+     * Otherwise this function calls policy.run( count, task ) where task( first, last ) notifies the observers in the range [first, last).
+     * The policy must call the task for each range that covers the observers and return after all tasks have finished.
+     * So this function returns after all observers have been notified.
+     *
+     * Observers notified by this function are called concurrently and must be independent of each other.
+     * These observers must not connect or disconnect observers from this subject.
+     *
+     * \see pg::parallel_threads
+     */
+    template< typename P >
+    void notify_parallel( const P &policy, A... args ) const
+    {
+        const typename detail::subject_base< A... >::notification n( *this );
+        const auto &observers   = detail::subject_base< A... >::observers();
+        const auto notify_range = [ & ]( std::size_t first, const std::size_t last )
+        {
+            for( ; first < last ; ++first )
+            {
+                const auto &s = observers[ first ];
+                if( s.o ) PG_OBSERVER_LIKELY
+                {
+                    s.notify( s.o, args... );
+                }
+            }
+        };
+
+        if( observers.size() < policy.threshold )
+        {
+            notify_range( 0, observers.size() );
+        }
+        else
+        {
+            policy.run( observers.size(), notify_range );
+        }
+    }
+};
+
+/**
+ * \brief A subject that takes the values that are not cheap to copy by const reference.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The values are passed by const reference from the caller of notify to the observers without making copies.
+ * For example a const_ref_subject< std::string, int > is a pg::subject< const std::string &, int >.
+ * Observers can be connected with callables that take the values by value or by const reference.
+ */
+template< typename ...A >
+using const_ref_subject = subject< detail::parameter_t< A >... >;
+
+/**
+ * \brief Class that calls the notification function of its observers and stores small callables inline.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * This subject has the same interface as pg::subject.
+ * Callables of observers that are trivially copyable and fit in a few pointers, for example lambdas that capture one or two references,
+ * are copied into the subject's container of observers.
+ * Notifying these observers is a sequential walk through the container without accessing the observer objects.
+ * Other observers are notified like pg::subject does.
+ *
+ * \note Only the copy stored in the subject is invoked at notification.
+ *
+ * \see observer::get_inline_notify_function
+ */
+template< typename ...A >
+class inline_subject : public detail::inline_subject_base< A... >
+{
+    inline_subject( const inline_subject< A... > & ) = delete;
+    inline_subject< A... >& operator=( const inline_subject< A... > & ) = delete;
+
+public:
+    inline_subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers observers connected to this subject.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     */
+    void notify( A... args ) const
+    {
+        const typename detail::inline_subject_base< A... >::notification n( *this );
+        for( const auto &s : detail::inline_subject_base< A... >::observers() )
+        {
+            if( s.o ) PG_OBSERVER_LIKELY
+            {
+                s.notify( s.o, s.storage, args... );
+            }
+        }
+    }
+};
+
+/**
+ * \brief Class that calls the notification function of its observers.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * This subject type is blockable.
+ * It maintains a block count that is tested before the notification of its observers.
+ * This subject blocks notifications when the block count is non-zero.
+ *
+ * \see observer
+ */
+template< typename ...A >
+class blockable_subject : public detail::subject_base< A... >
+{
+    blockable_subject( const blockable_subject< A... > & ) = delete;
+    blockable_subject< A... >& operator=( const blockable_subject< A... > & ) = delete;
+
+    int block_count = 0;
+
+public:
+    blockable_subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers observers connected to this subject when not blocked.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     */
+    void notify( A... args ) const
+    {
+        if( !block_count )
+        {
+            const typename detail::subject_base< A... >::notification n( *this );
+            detail::notify_slots( detail::subject_base< A... >::observers(), detail::has_reference_parameters< A... >(), args... );
+        }
+    }
+
+    /**
+     * \brief Blocks the notification of its observers when called.
+     * 
+     * This function can be called multiple times which increases a block count.
+     * You must call \em unblock the same number of times to unblock the subject or call \em set_block_state( false ).
+     *
+     * Notifications are not buffered when the subject is blocked.
+     *
+     * \see blockable_subject::unblock blockable_subject::set_block_state
+     */
+    void block() noexcept
+    {
+        ++block_count;
+    }
+
+    /**
+     * \brief Decreases the block count and unblocks the subject when the count got 0.
+     *
+     * This function can be called multiple times even when the subject is already unblocked.
+     *
+     * \see blockable_subject::block blockable_subject::set_block_state
+     */
+    void unblock() noexcept
+    {
+        if( block_count > 0 )
+        {
+            --block_count;
+        }
+    }
+
+    /**
+     * \brief Overrides the block count when the state differs from the current block state.
+     *
+     * \param block_state The new block state.
+     *
+     * \return Returns the old block state.
+     *
+     * When the block count is 0 when the block_state is true, the block count is set to 1.
+     * In case the block count is larger than 0 and the block_state is false, the block count is set to 0.
+     *
+     * The block count won't change if block_state is true and the block count is 0 or the block_state is false and the block count is 0.
+     *
+     * \see blockable_subject::block blockable_subject::unblock
+     */
+    bool set_block_state( bool block_state ) noexcept
+    {
+        if( block_count && !block_state )
+        {
+            block_count = 0;
+            return true;
+        }
+        else if( !block_count && block_state )
+        {
+            block_count = 1;
+            return false;
+        }
+
+        return block_state; // No state change
+    }
+
+    /**
+     * \brief Returns true when the subject is blocked.
+     */
+    bool is_blocked() const noexcept
+    {
+        return block_count != 0;
+    }
+};
+
+/**
+ * \brief A blockable subject that defers the notifications while it is blocked.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * Notifications while the subject is blocked are coalesced into one pending notification.
+ * The observers are notified with the pending notification when the subject gets unblocked,
+ * for example when the outermost pg::subject_blocker is destroyed.
+ * Without a merge function the pending notification holds the values of the latest notification.
+ *
+ * The pending values are stored as their decayed types, a subject of const std::string & stores a std::string.
+ *
+ * \note The pending notification is delivered from unblock, which is called from the noexcept destructor of pg::subject_blocker.
+ *       An exception thrown by an observer at that moment calls std::terminate.
+ *
+ * \see pg::blockable_subject pg::subject_blocker
+ */
+template< typename ...A >
+class coalescing_subject : public detail::subject_base< A... >
+{
+public:
+    /**
+     * \brief The type of the pending notification.
+     */
+    using event_type = typename observer< A... >::event_type;
+
+    /**
+     * \brief A function that merges the values of the latest notification into the pending notification.
+     */
+    using merge_function = void ( * )( event_type & pending, event_type && latest );
+
+private:
+    coalescing_subject( const coalescing_subject< A... > & ) = delete;
+    coalescing_subject< A... >& operator=( const coalescing_subject< A... > & ) = delete;
+
+    // The pending notification is only constructed when m_pending is true.
+    union pending_event
+    {
+        pending_event() noexcept {}
+        ~pending_event() noexcept {}
+
+        event_type e;
+    };
+
+    const merge_function m_merge;
+    int                  m_block_count = 0;
+    bool                 m_pending     = false;
+    pending_event        m_event;
+
+    template< std::size_t ...I >
+    void notify_event( event_type &e, std::index_sequence< I... > ) const
+    {
+        const typename detail::subject_base< A... >::notification n( *this );
+        detail::notify_slots( detail::subject_base< A... >::observers(), detail::has_reference_parameters< A... >(), std::get< I >( e )... );
+    }
+
+    // The pending notification is taken before notifying so that observers can block and notify this subject again.
+    void notify_pending()
+    {
+        if( m_pending )
+        {
+            event_type e( std::move( m_event.e ) );
+            discard();
+            notify_event( e, std::index_sequence_for< A... >() );
+        }
+    }
+
+public:
+    /**
+     * \param merge An optional function that merges the deferred notifications, for example a capture-less lambda.
+     */
+    explicit coalescing_subject( merge_function merge = nullptr ) noexcept
+            : m_merge( merge )
+    {}
+
+    ~coalescing_subject() noexcept
+    {
+        discard();
+    }
+
+    /**
+     * \brief Notifies the observers connected to this subject or defers the notification when the subject is blocked.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * The observers are notified in the order they are connected.
+     */
+    void notify( A... args )
+    {
+        if( !m_block_count )
+        {
+            const typename detail::subject_base< A... >::notification n( *this );
+            detail::notify_slots( detail::subject_base< A... >::observers(), detail::has_reference_parameters< A... >(), args... );
+        }
+        else if( !m_pending )
+        {
+            new( &m_event.e ) event_type( std::forward< A >( args )... );
+            m_pending = true;
+        }
+        else if( m_merge )
+        {
+            m_merge( m_event.e, event_type( std::forward< A >( args )... ) );
+        }
+        else
+        {
+            m_event.e = event_type( std::forward< A >( args )... );
+        }
+    }
+
+    /**
+     * \brief Increases the block count, notifications are deferred until the subject is unblocked.
+     *
+     * \see coalescing_subject::unblock coalescing_subject::set_block_state
+     */
     void block() noexcept
     {
-        ++block_count;
+        ++m_block_count;
+    }
+
+    /**
+     * \brief Decreases the block count and notifies the pending notification when the count got 0.
+     *
+     * This function can be called multiple times even when the subject is already unblocked.
+     *
+     * \see coalescing_subject::block coalescing_subject::set_block_state
+     */
+    void unblock()
+    {
+        if( m_block_count > 0 && --m_block_count == 0 )
+        {
+            notify_pending();
+        }
+    }
+
+    /**
+     * \brief Overrides the block count when the state differs from the current block state.
+     *
+     * \param block_state The new block state.
+     *
+     * \return Returns the old block state.
+     *
+     * Unblocking the subject notifies the pending notification.
+     *
+     * \see coalescing_subject::block coalescing_subject::unblock
+     */
+    bool set_block_state( bool block_state )
+    {
+        if( m_block_count && !block_state )
+        {
+            m_block_count = 0;
+            notify_pending();
+            return true;
+        }
+        else if( !m_block_count && block_state )
+        {
+            m_block_count = 1;
+            return false;
+        }
+
+        return block_state; // No state change
+    }
+
+    /**
+     * \brief Returns true when a deferred notification is pending.
+     */
+    bool pending() const noexcept
+    {
+        return m_pending;
+    }
+
+    /**
+     * \brief Discards the pending notification without notifying the observers.
+     */
+    void discard() noexcept
+    {
+        if( m_pending )
+        {
+            m_event.e.~event_type();
+            m_pending = false;
+        }
+    }
+};
+
+/**
+ * \brief Passed to the observers of a pg::priority_subject so that an observer can end the notification.
+ */
+class dispatch_control
+{
+    bool m_stopped = false;
+
+public:
+    /**
+     * \brief Stops the notification, the observers with a lower priority are not notified.
+     */
+    void stop() noexcept
+    {
+        m_stopped = true;
+    }
+
+    /**
+     * \brief Returns true when an observer stopped the notification.
+     */
+    bool stopped() const noexcept
+    {
+        return m_stopped;
+    }
+};
+
+/**
+ * \brief A subject that notifies its observers from the highest priority to the lowest priority.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The observers receive a pg::dispatch_control after the values of the notification.
+ * An observer that consumes a notification calls pg::dispatch_control::stop to end the notification.
+ * Like with the other subjects, observers may ignore the dispatch control when they accept fewer parameters.
+ *
+ * The observers are sorted on priority when they are connected, notifying doesn't sort them.
+ * Observers with the same priority are notified in the order they are connected.
+ *
+ * \see pg::priority_subject::with_priority
+ */
+template< typename ...A >
+class priority_subject : public detail::basic_subject_base< detail::priority_slot< A..., dispatch_control & >, A..., dispatch_control & >
+{
+    using base = detail::basic_subject_base< detail::priority_slot< A..., dispatch_control & >, A..., dispatch_control & >;
+
+    priority_subject( const priority_subject< A... > & ) = delete;
+    priority_subject< A... >& operator=( const priority_subject< A... > & ) = delete;
+
+    int m_next_priority = 0;
+
+public:
+    priority_subject() noexcept = default;
+
+    /**
+     * \brief Sets the priority for the next observer that is connected.
+     *
+     * \param priority The priority of the observer, observers with a higher priority are notified first.
+     *
+     * \return Returns a reference to this subject so that it can be passed to the connect functions.
+     *
+     * \code
+     * pg::priority_subject< const key_event & > s;
+     * auto connection = pg::connect( s.with_priority( 10 ), []( const key_event &e, pg::dispatch_control &c ){ c.stop(); } );
+     * \endcode
+     */
+    priority_subject< A... > & with_priority( const int priority ) noexcept
+    {
+        m_next_priority = priority;
+        return *this;
+    }
+
+    /**
+     * \brief Connects an observer with the priority that was set with with_priority or with priority 0.
+     *
+     * \param o The observer.
+     */
+    void connect( observer< A..., dispatch_control & > * const o ) noexcept
+    {
+        base::connect_ordered( detail::priority_slot< A..., dispatch_control & >( o, m_next_priority ) );
+        m_next_priority = 0;
+    }
+
+    /**
+     * \brief Notifies the observers from the highest priority to the lowest until an observer stops the notification.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * \return Returns true when an observer stopped the notification.
+     */
+    bool notify( A... args ) const
+    {
+        const typename base::notification n( *this );
+        dispatch_control control;
+        for( const auto &s : base::observers() )
+        {
+            if( s.o ) PG_OBSERVER_LIKELY
+            {
+                s.notify( s.o, args..., control );
+                if( control.stopped() )
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+namespace detail
+{
+
+// Combiners that have a done function end the notification when done returns true.
+template< typename C, typename = void >
+struct has_done : std::false_type
+{};
+
+template< typename C >
+struct has_done< C, decltype( void( std::declval< const C & >().done() ) ) > : std::true_type
+{};
+
+template< typename C >
+inline bool combiner_done( const C &c, std::true_type ) noexcept
+{
+    return c.done();
+}
+
+template< typename C >
+inline bool combiner_done( const C &, std::false_type ) noexcept
+{
+    return false;
+}
+
+}
+
+/**
+ * \brief A combiner for pg::collecting_subject that sums the returned values.
+ */
+template< typename T >
+class sum
+{
+    T m_value{};
+
+public:
+    template< typename V >
+    void operator()( V&& value )
+    {
+        m_value += std::forward< V >( value );
+    }
+
+    T result() const
+    {
+        return m_value;
+    }
+};
+
+/**
+ * \brief A combiner for pg::collecting_subject that keeps the smallest returned value.
+ *
+ * The result is a value initialized T when no value was returned.
+ */
+template< typename T >
+class minimum
+{
+    T    m_value{};
+    bool m_empty = true;
+
+public:
+    template< typename V >
+    void operator()( V&& value )
+    {
+        if( m_empty || value < m_value )
+        {
+            m_value = std::forward< V >( value );
+            m_empty = false;
+        }
+    }
+
+    T result() const
+    {
+        return m_value;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_empty;
+    }
+};
+
+/**
+ * \brief A combiner for pg::collecting_subject that keeps the largest returned value.
+ *
+ * The result is a value initialized T when no value was returned.
+ */
+template< typename T >
+class maximum
+{
+    T    m_value{};
+    bool m_empty = true;
+
+public:
+    template< typename V >
+    void operator()( V&& value )
+    {
+        if( m_empty || m_value < value )
+        {
+            m_value = std::forward< V >( value );
+            m_empty = false;
+        }
+    }
+
+    T result() const
+    {
+        return m_value;
+    }
+
+    bool empty() const noexcept
+    {
+        return m_empty;
+    }
+};
+
+/**
+ * \brief A combiner for pg::collecting_subject that is true when an observer returned true.
+ *
+ * The notification ends at the first observer that returns true.
+ */
+class any_of
+{
+    bool m_value = false;
+
+public:
+    void operator()( const bool value ) noexcept
+    {
+        m_value = m_value || value;
+    }
+
+    bool result() const noexcept
+    {
+        return m_value;
+    }
+
+    bool done() const noexcept
+    {
+        return m_value;
+    }
+};
+
+/**
+ * \brief A combiner for pg::collecting_subject that keeps the value that the last observer returned.
+ */
+template< typename T >
+class last
+{
+    T m_value{};
+
+public:
+    template< typename V >
+    void operator()( V&& value )
+    {
+        m_value = std::forward< V >( value );
+    }
+
+    T result() const
+    {
+        return m_value;
+    }
+};
+
+/**
+ * \brief A combiner for pg::collecting_subject that folds the returned values with a function.
+ *
+ * \tparam T The type of the result.
+ * \tparam F The type of the function that is called as function( T accumulated, value ) and returns the new accumulated value.
+ *
+ * \see pg::make_reducer
+ */
+template< typename T, typename F >
+class reducer
+{
+    T m_value;
+    F m_function;
+
+public:
+    reducer( T init, F function )
+            : m_value( std::move( init ) )
+            , m_function( std::move( function ) )
+    {}
+
+    template< typename V >
+    void operator()( V&& value )
+    {
+        m_value = m_function( std::move( m_value ), std::forward< V >( value ) );
+    }
+
+    T result() const
+    {
+        return m_value;
+    }
+};
+
+/**
+ * \brief Creates a pg::reducer with an initial value and a fold function.
+ */
+template< typename T, typename F >
+inline reducer< T, typename std::decay< F >::type > make_reducer( T init, F&& function )
+{
+    return reducer< T, typename std::decay< F >::type >( std::move( init ), std::forward< F >( function ) );
+}
+
+/**
+ * \brief A subject that folds the values that its observers return with a combiner.
+ *
+ * \tparam C The type of the combiner, for example pg::sum, pg::minimum, pg::maximum, pg::any_of, pg::last or pg::reducer.
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * The observers receive a pg::result_sink after the values of the notification.
+ * Callables and member functions that don't accept the sink have their return value passed to the combiner.
+ * The values are combined in place while the observers are notified, no container with the values is created.
+ *
+ * A combiner is a class with an operator() that takes a returned value and a result function.
+ * A combiner may have a done function, the notification ends when it returns true.
+ */
+template< typename C, typename ...A >
+class collecting_subject : public detail::subject_base< A..., result_sink< C > & >
+{
+    using base = detail::subject_base< A..., result_sink< C > & >;
+
+    collecting_subject( const collecting_subject< C, A... > & ) = delete;
+    collecting_subject< C, A... >& operator=( const collecting_subject< C, A... > & ) = delete;
+
+public:
+    collecting_subject() noexcept = default;
+
+    /**
+     * \brief Notifies the observers and folds their returned values with the given combiner.
+     *
+     * \param combiner The combiner that receives the returned values.
+     * \param args     The values passed to the observer's notification function.
+     */
+    void collect( C &combiner, A... args ) const
+    {
+        const typename base::notification n( *this );
+        result_sink< C > sink( combiner );
+        for( const auto &s : base::observers() )
+        {
+            if( s.o ) PG_OBSERVER_LIKELY
+            {
+                s.notify( s.o, args..., sink );
+                if( detail::combiner_done( combiner, detail::has_done< C >() ) )
+                {
+                    return;
+                }
+            }
+        }
+    }
+
+    /**
+     * \brief Notifies the observers with a default constructed combiner.
+     *
+     * \param args The values passed to the observer's notification function.
+     *
+     * \return Returns the result of the combiner.
+     */
+    auto notify( A... args ) const
+    {
+        C combiner;
+        collect( combiner, args... );
+        return combiner.result();
+    }
+};
+
+/**
+ * \brief A subject with a fixed set of observers that is defined at compile time.
+ *
+ * \tparam F The types of the callables that are notified, for example lambdas, functors or function pointers.
+ *
+ * The callables are stored in the subject and called in the order of the template parameters.
+ * A notification is a sequence of direct calls without a container or virtual functions so that the compiler can inline the callables.
+ * Like the observers of other subjects, the callables may ignore the trailing values of a notification.
+ *
+ * Observers cannot be connected to or disconnected from this subject.
+ *
+ * \see pg::make_static_subject
+ */
+template< typename ...F >
+class static_subject
+{
+    std::tuple< F... > m_observers;
+
+    template< std::size_t ...I, typename ...A >
+    void notify_observers( std::index_sequence< I... >, A&... args )
+    {
+        using expand = int[];
+        ( void )expand{ 0, ( pg::invoke( std::get< I >( m_observers ), args... ), 0 )... };
+    }
+
+public:
+    /**
+     * \param observers The callables that are notified.
+     */
+    explicit static_subject( F... observers )
+            : m_observers( std::move( observers )... )
+    {}
+
+    /**
+     * \brief Calls the callables of this subject.
+     *
+     * \param args The values passed to the callables.
+     */
+    template< typename ...A >
+    void notify( A&&... args )
+    {
+        notify_observers( std::index_sequence_for< F... >(), args... );
+    }
+};
+
+/**
+ * \brief Creates a pg::static_subject for the given callables.
+ *
+ * \param observers The callables that are notified by the subject.
+ */
+template< typename ...F >
+inline static_subject< typename std::decay< F >::type... > make_static_subject( F&&... observers )
+{
+    return static_subject< typename std::decay< F >::type... >( std::forward< F >( observers )... );
+}
+
+/**
+ * \brief Blocks temporary the notifications of a subject.
+ *
+ * \tparam S The type of the blockable subject.
+ *
+ * This class use RAII. The class blocks notifications when it is constructed and unblocked at destruction,
+ * for example when a subject_blocker instance leaves its scope.
+ *
+ * A subject_blocker expects a blockable subject that has the following two methods;
+ * - [discarded] block() [const]
+ * - [discarded] unblock() [const]
+ *
+ * \see pg::blockable_subject
+ */
+template< typename S >
+class subject_blocker
+{
+    S * m_subject = nullptr;
+
+public:
+    subject_blocker() noexcept = default;
+
+    /**
+     * \param subject A reference to the subject which notifications must be blocked.
+     */
+    subject_blocker( S & subject ) noexcept
+            : m_subject( &subject )
+    {
+        m_subject->block();
+    }
+
+    ~subject_blocker() noexcept
+    {
+        if( m_subject )
+        {
+            m_subject->unblock();
+        }
+    }
+};
+
+namespace detail
+{
+
+template< template< class, class, class... > class D, typename B, typename S >
+struct observer_type_factory : observer_type_factory< D, B, decltype( &S::connect ) >
+{};
+
+template< template< class, class, class... > class D, typename B, typename R, typename S, typename ...Ao >
+struct observer_type_factory< D, B, R ( S:: * )( observer< Ao... > * ) noexcept >
+{
+    using type = D< B, S, Ao... >;
+};
+
+template< template< class, class, class... > class D, typename B, typename R, typename S, typename ...Ao >
+struct observer_type_factory< D, B, R ( S:: * )( observer< Ao... > * ) const noexcept >
+{
+    using type = D< B, S, Ao... >;
+};
+
+// Connects an observer to a subject of which connect can fail by returning false.
+template< typename S, typename O >
+inline bool try_connect( S &s, O * const o, std::true_type ) noexcept
+{
+    return s.connect( o );
+}
+
+template< typename S, typename O >
+inline bool try_connect( S &s, O * const o, std::false_type ) noexcept
+{
+    s.connect( o );
+    return true;
+}
+
+template< typename S, typename O >
+inline bool try_connect( S &s, O * const o ) noexcept
+{
+    return try_connect( s, o, std::is_same< decltype( s.connect( o ) ), bool >() );
+}
+
+// Copies the callable of an observer into the storage of a subject, see observer::get_inline_notify_function.
+template< typename T >
+bool copy_to_storage( const T &, void *, std::size_t, std::false_type ) noexcept
+{
+    return false;
+}
+
+template< typename T >
+bool copy_to_storage( const T &object, void * const storage, const std::size_t size, std::true_type ) noexcept
+{
+    if( sizeof( T ) > size )
+    {
+        return false;
+    }
+
+    new( storage ) T( object );
+    return true;
+}
+
+template< typename T >
+bool copy_to_storage( const T &object, void * const storage, const std::size_t size ) noexcept
+{
+    using is_relocatable = std::integral_constant< bool, std::is_trivially_copyable< T >::value &&
+                                                         std::is_trivially_destructible< T >::value &&
+                                                         alignof( T ) <= alignof( std::max_align_t ) >;
+    return copy_to_storage( object, storage, size, is_relocatable() );
+}
+
+template< typename O, typename F, typename ...Ao >
+class member_function_observer
+{
+    O * const m_instance;
+    F         m_function;
+
+protected:
+    member_function_observer( O * instance, F function ) noexcept
+            : m_instance( instance )
+            , m_function( function )
+    {}
+
+    template< typename ...Ar >
+    void invoke( Ao... args, Ar&&... args_rest )
+    {
+        detail::invoke_and_collect( [ & ]() -> decltype( auto ) { return ( m_instance->*m_function )( std::forward< Ao >( args )... ); }, args..., args_rest... );
+    }
+
+    bool copy_to( void * const storage, const std::size_t size ) const noexcept
+    {
+        return copy_to_storage( *this, storage, size );
+    }
+
+    template< typename ...As >
+    static void invoke_stored( void * const storage, As&&... args )
+    {
+        static_cast< member_function_observer * >( storage )->invoke( std::forward< As >( args )... );
+    }
+};
+
+template< typename F >
+class function_observer
+{
+    F m_function;
+
+protected:
+    function_observer( F&& function ) noexcept
+            : m_function( std::forward< F >( function ) )
+    {}
+
+    template< typename ...As >
+    void invoke( As&&... args )
+    {
+        detail::invoke_and_collect( [ & ]() -> decltype( auto ) { return detail::invoke_helper< F >::invoke( m_function, std::forward< As >( args )... ); }, args... );
+    }
+
+    bool copy_to( void * const storage, const std::size_t size ) const noexcept
+    {
+        return copy_to_storage( *this, storage, size );
+    }
+
+    template< typename ...As >
+    static void invoke_stored( void * const storage, As&&... args )
+    {
+        static_cast< function_observer * >( storage )->invoke( std::forward< As >( args )... );
+    }
+};
+
+// Calls set_observer_block_state of subjects that have this function, other subjects can't block observers.
+template< typename S, typename O, typename = void >
+struct has_observer_block_state : std::false_type
+{};
+
+template< typename S, typename O >
+struct has_observer_block_state< S, O, decltype( void( std::declval< S & >().set_observer_block_state( std::declval< O * >(), true ) ) ) > : std::true_type
+{};
+
+template< typename S, typename O >
+inline bool set_observer_block_state( S &s, O * const o, const bool state, std::true_type ) noexcept
+{
+    return s.set_observer_block_state( o, state );
+}
+
+template< typename S, typename O >
+inline bool set_observer_block_state( S &, O * const, const bool, std::false_type ) noexcept
+{
+    return false;
+}
+
+template< typename S, typename O >
+inline bool set_observer_block_state( S &s, O * const o, const bool state ) noexcept
+{
+    return set_observer_block_state( s, o, state, has_observer_block_state< S, O >() );
+}
+
+// Reserves room in subjects that have a reserve function, other subjects are left as they are.
+template< typename S, typename = void >
+struct has_reserve : std::false_type
+{};
+
+template< typename S >
+struct has_reserve< S, decltype( void( std::declval< S & >().reserve( std::declval< S & >().observer_count() ) ) ) > : std::true_type
+{};
+
+template< typename S >
+inline void reserve( S &s, const std::size_t count, std::true_type )
+{
+    s.reserve( s.observer_count() + count );
+}
+
+template< typename S >
+inline void reserve( S &, const std::size_t, std::false_type ) noexcept
+{}
+
+// Detects if a subject can disconnect observers without compacting, for bulk removals.
+template< typename S, typename = void >
+struct has_sweep : std::false_type
+{};
+
+template< typename S >
+struct has_sweep< S, decltype( void( std::declval< S & >().sweep() ) ) > : std::true_type
+{};
+
+template< typename S, typename O >
+inline void mark_disconnected( S &s, const O * const o, std::true_type ) noexcept
+{
+    s.mark_disconnected( o );
+}
+
+template< typename S, typename O >
+inline void mark_disconnected( S &s, const O * const o, std::false_type ) noexcept
+{
+    s.disconnect( o );
+}
+
+template< typename S >
+inline void sweep( S &s, std::true_type ) noexcept
+{
+    s.sweep();
+}
+
+template< typename S >
+inline void sweep( S &, std::false_type ) noexcept
+{}
+
+// Allocates the observer nodes of a connection_owner.
+// Nodes are carved from blocks which sizes are doubled for each new block up to a maximum.
+// Released nodes are kept in a free list per size class so that they can be reused by nodes of the same size class.
+// All blocks are released at once when the pool is destroyed.
+// The pool's bookkeeping is stored in the first block so that an unused pool is just one pointer.
+class node_pool
+{
+    static constexpr std::size_t granularity    = alignof( std::max_align_t );
+    static constexpr std::size_t size_classes   = 8;
+    static constexpr std::size_t max_node_size  = granularity * size_classes;
+    static constexpr std::size_t min_block_size = 256;
+    static constexpr std::size_t max_block_size = 4096;
+
+    struct free_node
+    {
+        free_node * next;
+    };
+
+    struct block
+    {
+        block * next;
+    };
+
+    struct state
+    {
+        block       *blocks;
+        char        *current;
+        char        *end;
+        std::size_t next_block_size;
+        free_node   *free_nodes[ size_classes ];
+    };
+
+    static constexpr std::size_t round_up( std::size_t size ) noexcept
+    {
+        return ( size + granularity - 1 ) / granularity * granularity;
+    }
+
+    static constexpr bool is_pooled( std::size_t size, std::size_t alignment ) noexcept
+    {
+        return size <= max_node_size && alignment <= granularity;
+    }
+
+    static constexpr std::size_t block_header_size = ( sizeof( block ) + granularity - 1 ) / granularity * granularity;
+    static constexpr std::size_t state_size        = ( sizeof( state ) + granularity - 1 ) / granularity * granularity;
+
+    state * m_state = nullptr;
+
+    node_pool( const node_pool & ) = delete;
+    node_pool & operator=( const node_pool & ) = delete;
+
+    void add_block()
+    {
+        const std::size_t block_size = m_state->next_block_size;
+        auto b                       = static_cast< block * >( ::operator new( block_size ) );
+
+        b->next                  = m_state->blocks;
+        m_state->blocks          = b;
+        m_state->current         = reinterpret_cast< char * >( b ) + block_header_size;
+        m_state->end             = reinterpret_cast< char * >( b ) + block_size;
+        m_state->next_block_size = block_size < max_block_size ? block_size * 2 : max_block_size;
+    }
+
+    void * allocate( std::size_t size )
+    {
+        if( !m_state )
+        {
+            // The first block starts with the pool's bookkeeping followed by the memory for the nodes.
+            auto first = static_cast< char * >( ::operator new( min_block_size ) );
+            m_state    = new( first ) state{ nullptr, first + state_size, first + min_block_size, min_block_size * 2, {} };
+        }
+
+        const std::size_t size_class = round_up( size ) / granularity - 1;
+        free_node * const f          = m_state->free_nodes[ size_class ];
+        if( f )
+        {
+            m_state->free_nodes[ size_class ] = f->next;
+            return f;
+        }
+
+        size = round_up( size );
+        if( static_cast< std::size_t >( m_state->end - m_state->current ) < size )
+        {
+            add_block();
+        }
+
+        void * const p = m_state->current;
+        m_state->current += size;
+        return p;
+    }
+
+    void deallocate( void * p, std::size_t size ) noexcept
+    {
+        const std::size_t size_class = round_up( size ) / granularity - 1;
+        auto f                       = static_cast< free_node * >( p );
+
+        f->next                           = m_state->free_nodes[ size_class ];
+        m_state->free_nodes[ size_class ] = f;
     }
 
-    /**
-     * \brief Decreases the block count and unblocks the subject when the count got 0.
-     *
-     * This function can be called multiple times even when the subject is already unblocked.
-     *
-     * \see blockable_subject::block blockable_subject::set_block_state
-     */
-    void unblock() noexcept
+public:
+    node_pool() noexcept = default;
+
+    ~node_pool() noexcept
     {
-        if( block_count > 0 )
+        if( m_state )
         {
-            --block_count;
+            for( block * b = m_state->blocks ; b ; )
+            {
+                block * const next = b->next;
+                ::operator delete( b );
+                b = next;
+            }
+            ::operator delete( m_state );
         }
     }
 
-    /**
-     * \brief Overrides the block count when the state differs from the current block state.
-     *
-     * \param block_state The new block state.
-     *
-     * \return Returns the old block state.
-     *
-     * When the block count is 0 when the block_state is true, the block count is set to 1.
-     * In case the block count is larger than 0 and the block_state is false, the block count is set to 0.
-     *
-     * The block count won't change if block_state is true and the block count is 0 or the block_state is false and the block count is 0.
-     *
-     * \see blockable_subject::block blockable_subject::unblock
-     */
-    bool set_block_state( bool block_state ) noexcept
+    template< typename T, typename ...Args >
+    T * create( Args&&... args )
     {
-        if( block_count && !block_state )
+        void * const p = is_pooled( sizeof( T ), alignof( T ) ) ? allocate( sizeof( T ) ) : ::operator new( sizeof( T ) );
+        return new( p ) T( std::forward< Args >( args )... );
+    }
+
+    template< typename T >
+    void destroy( T * const p ) noexcept
+    {
+        p->~T();
+        if( is_pooled( sizeof( T ), alignof( T ) ) )
         {
-            block_count = 0;
-            return true;
+            deallocate( p, sizeof( T ) );
         }
-        else if( !block_count && block_state )
+        else
         {
-            block_count = 1;
-            return false;
+            ::operator delete( p );
         }
-
-        return block_state; // No state change
     }
 };
 
-/**
- * \brief Blocks temporary the notifications of a subject.
- *
- * \tparam S The type of the blockable subject.
- *
- * This class use RAII. The class blocks notifications when it is constructed and unblocked at destruction,
- * for example when a subject_blocker instance leaves its scope.
- *
- * A subject_blocker expects a blockable subject that has the following two methods;
- * - [discarded] block() [const]
- * - [discarded] unblock() [const]
- *
- * \see pg::blockable_subject
- */
-template< typename S >
-class subject_blocker
+// The observer of a connection of a connection owner, it stores the callable B and is connected to a subject S.
+// The connection owner O is the friend of this observer and provides the hooks remove_observer, which removes the
+// observer when its subject disconnects it, and destroy_observer, which destroys the observer and releases its memory.
+// The owner sets index to the position of the observer in its storage before it connects the observer.
+template< typename O, typename B, typename S, typename ...Ao >
+class owner_observer final : public observer< Ao... >, B
 {
-    S * m_subject = nullptr;
+    O &m_owner;
+    S &m_subject;
 
-public:
-    subject_blocker() noexcept = default;
+    virtual void notify( Ao... args ) override
+    {
+        B::invoke( std::forward< Ao >( args )... );
+    }
 
-    /**
-     * \param subject A reference to the subject which notifications must be blocked.
-     */
-    subject_blocker( S & subject ) noexcept
-            : m_subject( &subject )
+    static void notify_direct( observer< Ao... > * const o, parameter_t< Ao >... args )
     {
-        m_subject->block();
+        static_cast< owner_observer * >( o )->B::invoke( std::forward< parameter_t< Ao > >( args )... );
     }
 
-    ~subject_blocker() noexcept
+    virtual typename observer< Ao... >::notify_function get_notify_function() const noexcept override
     {
-        if( m_subject )
-        {
-            m_subject->unblock();
-        }
+        return &owner_observer::notify_direct;
     }
-};
 
-namespace detail
-{
+    static void notify_inline( observer< Ao... > *, void * const storage, parameter_t< Ao >... args )
+    {
+        B::invoke_stored( storage, std::forward< parameter_t< Ao > >( args )... );
+    }
 
-template< template< class, class, class... > class D, typename B, typename S >
-struct observer_type_factory : observer_type_factory< D, B, decltype( &S::connect ) >
-{};
+    virtual typename observer< Ao... >::inline_notify_function get_inline_notify_function( void * const storage, const std::size_t size ) const noexcept override
+    {
+        return B::copy_to( storage, size ) ? &owner_observer::notify_inline : nullptr;
+    }
 
-template< template< class, class, class... > class D, typename B, typename R, typename S, typename ...Ao >
-struct observer_type_factory< D, B, R ( S:: * )( observer< Ao... > * ) noexcept >
-{
-    using type = D< B, S, Ao... >;
-};
+    virtual void disconnect() noexcept override
+    {
+        m_owner.remove_observer( index );
+    }
 
-template< template< class, class, class... > class D, typename B, typename R, typename S, typename ...Ao >
-struct observer_type_factory< D, B, R ( S:: * )( observer< Ao... > * ) const noexcept >
-{
-    using type = D< B, S, Ao... >;
-};
+    virtual void remove_from_subject() noexcept override
+    {
+        mark_disconnected( m_subject, static_cast< observer< Ao... > * >( this ), has_sweep< S >() );
+    }
 
-template< typename O, typename F, typename ...Ao >
-class member_function_observer
-{
-    O * const m_instance;
-    F         m_function;
+    virtual void sweep_subject() noexcept override
+    {
+        sweep( m_subject, has_sweep< S >() );
+    }
 
-protected:
-    member_function_observer( O * instance, F function ) noexcept
-            : m_instance( instance )
-            , m_function( function )
-    {}
+    virtual void destroy() noexcept override
+    {
+        m_owner.destroy_observer( this );
+    }
 
-    template< typename ...Ar >
-    void invoke( Ao&&... args, Ar&&... )
+    virtual bool set_block_state( const bool state ) noexcept override
     {
-        ( m_instance->*m_function )( std::forward< Ao >( args )... );
+        return set_observer_block_state( m_subject, static_cast< observer< Ao... > * >( this ), state );
     }
-};
 
-template< typename F >
-class function_observer
-{
-    F m_function;
+    virtual bool is_connected_to( const void * const subject ) const noexcept override
+    {
+        return static_cast< const void * >( &m_subject ) == subject;
+    }
 
-protected:
-    function_observer( F&& function ) noexcept
-            : m_function( std::forward< F >( function ) )
+public:
+    std::uint32_t index = 0;
+
+    template< typename ...Ab >
+    owner_observer( O &owner, S &subject, Ab&&... args_base ) noexcept
+            : B( std::forward< Ab >( args_base )... )
+            , m_owner( owner )
+            , m_subject( subject )
     {}
+};
 
-    template< typename ...As >
-    void invoke( As&&... args )
+// Returns a number that identifies a connection owner in its connection handles, 0 identifies no connection owner.
+// The numbers are unique over all connection owners so that the handles of a destroyed connection owner don't match
+// a connection owner that is constructed later at the same address.
+inline std::uint32_t next_owner_id() noexcept
+{
+    static std::atomic< std::uint32_t > last_id{ 0 };
+
+    std::uint32_t id = last_id.fetch_add( 1, std::memory_order_relaxed ) + 1;
+    while( id == 0 )
     {
-        detail::invoke_helper< F >::invoke( m_function, std::forward< As >( args )... );
+        id = last_id.fetch_add( 1, std::memory_order_relaxed ) + 1;
     }
-};
+    return id;
+}
 
 }
 
@@ -423,6 +2374,9 @@ protected:
  *
  * Connections that are made and thus owned by connection_owner are removed at destruction of connection_owner.
  *
+ * The observers of the connections are allocated from a pool that is owned by the connection_owner.
+ * Memory of disconnected observers is reused for new connections and the whole pool is released at once when the connection_owner is destroyed.
+ *
  * When connecting an observer to a subject, the connection_owner expects that a subject has the following methods;
  * - [discarded] connect( pg::observer< T... > * ) [const]
  * - [discarded] disconnect( [const] pg::observer< T... > * ) [const]
@@ -431,102 +2385,182 @@ protected:
  */
 class connection_owner
 {
-    class abstract_observer
-    {
-    public:
-        virtual ~abstract_observer() noexcept = default;
-        virtual void remove_from_subject() noexcept = 0;
-    };
+    using abstract_observer = detail::apex_observer;
+
+    template< typename O, typename B, typename S, typename ...Ao >
+    friend class detail::owner_observer;
 
     template< typename B, typename S, typename ...Ao >
-    class owner_observer final : public observer< Ao... >, public abstract_observer, B
+    using owner_observer = detail::owner_observer< connection_owner, B, S, Ao... >;
+
+    connection_owner( const connection_owner & ) = delete;
+    connection_owner & operator=( const connection_owner & ) = delete;
+
+    static constexpr std::uint32_t no_handle = ~std::uint32_t( 0 );
+
+    // The handles of the observers in the order in which they were added.
+    // Removed observers leave no_handle behind, like the nullptrs in the subjects, to keep that order.
+    // The tombstones are compacted when an observer is added, not when one is removed, so that destroying subjects
+    // with a lot of observers of this owner doesn't compact the owner over and over.
+    std::vector< std::uint32_t > m_observers;
+    std::size_t                  m_tombstones = 0;
+    detail::node_pool            m_pool;
+
+    // The connection handles refer to an entry of this slot map, the entries keep their index while the observers are compacted.
+    // The generation of an entry is increased when its observer is removed so that the handles of removed connections don't
+    // match the entry when it is reused by another observer.
+    // The link of an entry is the position of its observer in m_observers, or the next free entry when the entry is free.
+    struct handle
     {
-        connection_owner &m_owner;
-        S                &m_subject;
+        abstract_observer * o          = nullptr;
+        std::uint32_t       generation = 1;
+        std::uint32_t       link       = 0;
+    };
+
+    std::vector< handle > m_handles;
+    std::uint32_t         m_free_handles = no_handle;
+    const std::uint32_t   m_id           = detail::next_owner_id();
 
-        virtual void notify( Ao... args ) override
+    std::uint32_t acquire_handle( abstract_observer * const o ) noexcept
+    {
+        std::uint32_t index = m_free_handles;
+        if( index != no_handle )
         {
-            B::invoke( std::forward< Ao >( args )... );
+            m_free_handles = m_handles[ index ].link;
         }
-
-        virtual void disconnect() noexcept override
+        else
         {
-            m_owner.remove_observer( this );
+            index = static_cast< std::uint32_t >( m_handles.size() );
+            m_handles.emplace_back();
         }
+        m_handles[ index ].o = o;
+        return index;
+    }
 
-        virtual void remove_from_subject() noexcept override
+    void release_handle( const std::uint32_t index ) noexcept
+    {
+        handle &h = m_handles[ index ];
+        h.o       = nullptr;
+        if( ++h.generation == 0 )
         {
-            m_subject.disconnect( this );
+            h.generation = 1;
         }
+        h.link         = m_free_handles;
+        m_free_handles = index;
+    }
 
-    public:
-        template< typename ...Ab >
-        owner_observer( connection_owner &owner, S &subject, Ab&&... args_base ) noexcept
-                : B( std::forward< Ab >( args_base )... )
-                , m_owner( owner )
-                , m_subject( subject )
+    void compact() noexcept
+    {
+        std::size_t index = 0;
+        for( const auto h : m_observers )
         {
-            m_owner.add_observer( this );
-            m_subject.connect( this );
+            if( h != no_handle )
+            {
+                m_handles[ h ].link    = static_cast< std::uint32_t >( index );
+                m_observers[ index++ ] = h;
+            }
         }
-    };
-
-    connection_owner( const connection_owner & ) = delete;
-    connection_owner & operator=( const connection_owner & ) = delete;
-
-    std::vector< abstract_observer * > m_observers;
+        m_observers.resize( index );
+        m_tombstones = 0;
+    }
 
-    auto find_observer( const abstract_observer * const o )
+    void erase_observer( const std::uint32_t h ) noexcept
     {
-        auto it_find = std::find( m_observers.crbegin(), m_observers.crend(), o );
+        m_observers[ m_handles[ h ].link ] = no_handle;
+        ++m_tombstones;
+    }
 
-        return it_find == m_observers.crend() ? m_observers.cend() : ( ++it_find ).base();
+    void remove_observer( const std::uint32_t h ) noexcept
+    {
+        abstract_observer * const o = m_handles[ h ].o;
+        erase_observer( h );
+        release_handle( h );
+        o->destroy();
     }
 
-    void remove_observer( abstract_observer * const o ) noexcept
+    template< typename O >
+    void destroy_observer( O * const o ) noexcept
     {
-        auto it_find = find_observer( o );
-        if( it_find != m_observers.cend() ) PG_OBSERVER_LIKELY
-        {
-            m_observers.erase( it_find );
-            delete o;
-        }
+        m_pool.destroy( o );
     }
 
-    void add_observer( abstract_observer * const o ) noexcept
+    std::uint32_t add_observer( abstract_observer * const o ) noexcept
     {
-        m_observers.push_back( o );
+        if( m_tombstones > m_observers.size() / 2 )
+        {
+            compact();
+        }
+        const std::uint32_t h = acquire_handle( o );
+        m_handles[ h ].link   = static_cast< std::uint32_t >( m_observers.size() );
+        m_observers.push_back( h );
+        return h;
     }
 
 public:
     /**
      * \brief A handle to a subject <--> observer connection.
      *
-     * \note Reuse of this handle may lead to undefined behavior.
+     * The handle is an index and a generation in the connection owner's slot map of connections, and the id of the connection owner.
+     * It is trivially copyable and stays safe to use after the connection is removed;
+     * handles of removed connections and handles of other connection owners, also of destroyed connection owners,
+     * are ignored by the connection owner.
      *
      * \see pg::connection_owner::connect pg::connection_owner::disconnect
      */
     class connection
     {
         friend connection_owner;
-        abstract_observer * m_h = nullptr;
-
-        connection( abstract_observer * h )
-                : m_h( h )
+        std::uint32_t m_owner      = 0;
+        std::uint32_t m_handle     = 0;
+        std::uint32_t m_generation = 0;
+
+        connection( const std::uint32_t owner, const std::uint32_t h, const std::uint32_t generation ) noexcept
+                : m_owner( owner )
+                , m_handle( h )
+                , m_generation( generation )
         {}
 
     public:
         connection() noexcept = default;
     };
 
+private:
+    template< typename O, typename S, typename ...Ab >
+    connection create( S &s, Ab&&... args )
+    {
+        O * const o = m_pool.create< O >( *this, s, std::forward< Ab >( args )... );
+        o->index    = add_observer( o );
+        s.connect( o );
+        return connection( m_id, o->index, m_handles[ o->index ].generation );
+    }
+
+    abstract_observer * find_observer( const connection c ) const noexcept
+    {
+        return c.m_owner == m_id && c.m_handle < m_handles.size() && m_handles[ c.m_handle ].generation == c.m_generation ? m_handles[ c.m_handle ].o : nullptr;
+    }
+
+public:
+
     connection_owner() = default;
 
+    // The observers are removed from their subjects in two passes so that each subject is compacted once instead of repeatedly.
+    // The subjects don't move their observers while they are marked as disconnected which keeps all subject indices valid.
     ~connection_owner() noexcept
     {
         for( auto it = m_observers.crbegin() ; it != m_observers.crend() ; ++it )
         {
-            ( *it )->remove_from_subject();
-            delete *it;
+            if( *it != no_handle )
+            {
+                m_handles[ *it ].o->remove_from_subject();
+            }
+        }
+        for( auto it = m_observers.crbegin() ; it != m_observers.crend() ; ++it )
+        {
+            if( *it != no_handle )
+            {
+                m_handles[ *it ].o->sweep_subject();
+                m_handles[ *it ].o->destroy();
+            }
         }
     }
 
@@ -547,7 +2581,7 @@ public:
     connection connect( S &s, O * instance, R ( O::* const function )( Ao... ) ) noexcept
     {
         using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< O, R ( O::* )( Ao... ), Ao... >, S >::type;
-        return new observer_type( *this, s, instance, function );
+        return create< observer_type >( s, instance, function );
     }
 
     /**
@@ -557,7 +2591,7 @@ public:
     connection connect( S &s, O * instance, R ( O::* const function )( Ao... ) const ) noexcept
     {
         using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< O, R ( O::* )( Ao... ) const, Ao... >, S >::type;
-        return new observer_type( *this, s, instance, function );
+        return create< observer_type >( s, instance, function );
     }
 
     /**
@@ -567,7 +2601,7 @@ public:
     connection connect( S &s, const O * instance, R ( O::* const function )( Ao... ) const ) noexcept
     {
         using observer_type = typename detail::observer_type_factory< owner_observer, detail::member_function_observer< const O, R ( O::* )( Ao... ) const, Ao... >, S >::type;
-        return new observer_type( *this, s, instance, function );
+        return create< observer_type >( s, instance, function );
     }
 
     /**
@@ -588,7 +2622,7 @@ public:
     connection connect( S &s, F&& function ) noexcept
     {
         using observer_type = typename detail::observer_type_factory< owner_observer, detail::function_observer< F >, S >::type;
-        return new observer_type( *this, s, std::forward< F >( function ) );
+        return create< observer_type >( s, std::forward< F >( function ) );
     }
 
     /**
@@ -598,7 +2632,7 @@ public:
     connection connect( S &s, R ( * function )( Af... ) ) noexcept
     {
         using observer_type = typename detail::observer_type_factory< owner_observer, detail::function_observer< R ( * )( Af... ) >, S >::type;
-        return new observer_type( *this, s, std::forward< R ( * )( Af... ) >( function ) );
+        return create< observer_type >( s, std::forward< R ( * )( Af... ) >( function ) );
     }
 
     /**
@@ -610,16 +2644,117 @@ public:
      *
      * \see pg::connection_owner::connect
      */
-    void disconnect( connection c ) noexcept
+    void disconnect( const connection c ) noexcept
+    {
+        abstract_observer * const o = find_observer( c );
+        if( o ) PG_OBSERVER_LIKELY
+        {
+            o->remove_from_subject();
+            o->sweep_subject();
+            erase_observer( c.m_handle );
+            release_handle( c.m_handle );
+            o->destroy();
+        }
+    }
+
+    /**
+     * \brief Connects each callable of a range to a subject.
+     *
+     * \param s         The subject from which the callables will receive notifications.
+     * \param functions A range of callables such as a std::vector of std::function or an array of lambdas.
+     *
+     * Reserves room for the new connections in the connection owner and in the subject before the callables are connected.
+     * The callables are copied and stored in the connection_owner.
+     *
+     * \see pg::connection_owner::disconnect_all
+     */
+    template< typename S, typename C >
+    void connect_all( S &s, const C &functions )
+    {
+        using std::begin;
+        using std::end;
+        using function_type = typename std::decay< decltype( *begin( functions ) ) >::type;
+
+        const auto count = static_cast< std::size_t >( std::distance( begin( functions ), end( functions ) ) );
+        m_observers.reserve( m_observers.size() + count );
+        m_handles.reserve( m_observers.size() - m_tombstones + count );
+        detail::reserve( s, count, detail::has_reserve< S >() );
+
+        for( const auto &f : functions )
+        {
+            connect( s, function_type( f ) );
+        }
+    }
+
+    /**
+     * \brief Disconnects all observers of this connection owner from a subject.
+     *
+     * \param s The subject.
+     *
+     * The connections are removed in a single pass over the connections of this connection owner.
+     * Connections to other subjects are kept.
+     */
+    template< typename S >
+    void disconnect_all( S &s ) noexcept
     {
-        auto it_find = find_observer( c.m_h );
-        if( it_find != m_observers.cend() ) PG_OBSERVER_LIKELY
+        const void * const subject = static_cast< const void * >( &s );
+        for( auto &h : m_observers )
         {
-            c.m_h->remove_from_subject();
-            m_observers.erase( it_find );
-            delete c.m_h;
+            abstract_observer * const o = h != no_handle ? m_handles[ h ].o : nullptr;
+            if( o && o->is_connected_to( subject ) )
+            {
+                o->remove_from_subject();
+                release_handle( h );
+                h = no_handle;
+                ++m_tombstones;
+                o->destroy();
+            }
+        }
+        detail::sweep( s, detail::has_sweep< S >() );
+
+        if( m_tombstones > m_observers.size() / 2 )
+        {
+            compact();
         }
     }
+
+    /**
+     * \brief Reserves room for the given number of connections.
+     *
+     * \param capacity The number of connections for which memory is allocated at once.
+     */
+    void reserve( const std::size_t capacity )
+    {
+        m_observers.reserve( capacity + m_tombstones );
+        m_handles.reserve( capacity );
+    }
+
+    /**
+     * \brief Blocks or unblocks the notifications of a connection without disconnecting it.
+     *
+     * \param c     The connection handle.
+     * \param state Blocks the notifications when true, unblocks them when false.
+     *
+     * \return Returns the previous block state of the connection.
+     *          Returns false when the connection doesn't exist or when its subject doesn't support blocking observers.
+     *
+     * \see pg::subject::set_observer_block_state
+     */
+    bool set_block_state( const connection c, const bool state ) noexcept
+    {
+        abstract_observer * const o = find_observer( c );
+        return o ? o->set_block_state( state ) : false;
+    }
+
+    /**
+     * \brief Returns true when the connection exists.
+     *
+     * \param c The connection handle.
+     */
+    bool connected( const connection c ) const noexcept
+    {
+        return find_observer( c ) != nullptr;
+    }
 };
 
 /**
@@ -643,11 +2778,36 @@ class scoped_observer final : public observer< Ao... >, B
         B::invoke( std::forward< Ao >( args )... );
     }
 
+    static void notify_direct( observer< Ao... > * const o, detail::parameter_t< Ao >... args )
+    {
+        static_cast< scoped_observer * >( o )->B::invoke( std::forward< detail::parameter_t< Ao > >( args )... );
+    }
+
+    virtual typename observer< Ao... >::notify_function get_notify_function() const noexcept override
+    {
+        return &scoped_observer::notify_direct;
+    }
+
+    static void notify_inline( observer< Ao... > *, void * const storage, detail::parameter_t< Ao >... args )
+    {
+        B::invoke_stored( storage, std::forward< detail::parameter_t< Ao > >( args )... );
+    }
+
+    virtual typename observer< Ao... >::inline_notify_function get_inline_notify_function( void * const storage, const std::size_t size ) const noexcept override
+    {
+        return B::copy_to( storage, size ) ? &scoped_observer::notify_inline : nullptr;
+    }
+
     virtual void disconnect() noexcept override
     {
         m_subject = nullptr;
     }
 
+    virtual bool set_block_state( const bool state ) noexcept override
+    {
+        return m_subject ? set_observer_block_state( *m_subject, static_cast< observer< Ao... > * >( this ), state ) : false;
+    }
+
 public:
     template< typename ...Ab >
     scoped_observer( S &subject, Ab&&... args_base ) noexcept
@@ -734,6 +2894,19 @@ public:
         delete m_observer;
         m_observer = nullptr;
     }
+
+    /**
+     * \brief Blocks or unblocks the notifications of the connection without disconnecting it.
+     *
+     * \param state Blocks the notifications when true, unblocks them when false.
+     *
+     * \return Returns the previous block state of the connection.
+     *          Returns false when there is no connection or when its subject doesn't support blocking observers.
+     */
+    bool set_block_state( const bool state ) noexcept
+    {
+        return m_observer ? m_observer->set_block_state( state ) : false;
+    }
 };
 
 /**
@@ -0,0 +1,319 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <chrono>
+#include <tuple>
+#include <utility>
+
+namespace pg
+{
+
+namespace detail
+{
+
+template< typename F >
+class map_stage
+{
+    F m_function;
+
+public:
+    explicit map_stage( F function )
+            : m_function( std::move( function ) )
+    {}
+
+    template< typename N, typename ...V >
+    void operator()( const N &next, V&&... values )
+    {
+        next( pg::invoke( m_function, std::forward< V >( values )... ) );
+    }
+};
+
+template< typename F >
+class filter_stage
+{
+    F m_predicate;
+
+public:
+    explicit filter_stage( F predicate )
+            : m_predicate( std::move( predicate ) )
+    {}
+
+    template< typename N, typename ...V >
+    void operator()( const N &next, V&&... values )
+    {
+        if( pg::invoke( m_predicate, values... ) )
+        {
+            next( std::forward< V >( values )... );
+        }
+    }
+};
+
+template< typename T >
+class distinct_stage
+{
+    T    m_last{};
+    bool m_first = true;
+
+public:
+    template< typename N, typename V >
+    void operator()( const N &next, V&& value )
+    {
+        if( m_first || !( m_last == value ) )
+        {
+            m_last  = value;
+            m_first = false;
+            next( std::forward< V >( value ) );
+        }
+    }
+};
+
+class sample_stage
+{
+    std::size_t m_interval;
+    std::size_t m_count = 0;
+
+public:
+    explicit sample_stage( const std::size_t interval ) noexcept
+            : m_interval( interval ? interval : 1 )
+    {}
+
+    template< typename N, typename ...V >
+    void operator()( const N &next, V&&... values )
+    {
+        if( ++m_count == m_interval )
+        {
+            m_count = 0;
+            next( std::forward< V >( values )... );
+        }
+    }
+};
+
+class throttle_stage
+{
+    using clock = std::chrono::steady_clock;
+
+    clock::duration   m_interval;
+    clock::time_point m_next = clock::time_point::min();
+
+public:
+    explicit throttle_stage( const clock::duration interval ) noexcept
+            : m_interval( interval )
+    {}
+
+    template< typename N, typename ...V >
+    void operator()( const N &next, V&&... values )
+    {
+        const auto now = clock::now();
+        if( now >= m_next )
+        {
+            m_next = now + m_interval;
+            next( std::forward< V >( values )... );
+        }
+    }
+};
+
+template< typename S >
+class subject_sink
+{
+    S * m_subject;
+
+public:
+    explicit subject_sink( S &s ) noexcept
+            : m_subject( &s )
+    {}
+
+    template< typename ...V >
+    void operator()( V&&... values ) const
+    {
+        m_subject->notify( std::forward< V >( values )... );
+    }
+
+    bool active() const noexcept
+    {
+        return m_subject->observer_count() != 0;
+    }
+};
+
+// Sinks that are subjects are active when they have observers, other sinks are always active.
+template< typename S >
+inline bool sink_active( const subject_sink< S > &sink ) noexcept
+{
+    return sink.active();
+}
+
+template< typename F >
+inline bool sink_active( const F & ) noexcept
+{
+    return true;
+}
+
+template< typename S, typename ...V >
+inline void call_sink( subject_sink< S > &sink, V&&... values )
+{
+    sink( std::forward< V >( values )... );
+}
+
+template< typename F, typename ...V >
+inline void call_sink( F &sink, V&&... values )
+{
+    pg::invoke( sink, std::forward< V >( values )... );
+}
+
+}
+
+/**
+ * \brief A callable that passes a notification through a chain of operators to a sink.
+ *
+ * \tparam In The types of the values of the notifications that are passed to the pipeline.
+ * \tparam S  The types of the operators followed by the type of the sink.
+ *
+ * The operators are called directly by each other and can be inlined by the compiler,
+ * so that a pipeline is one observer for the subject no matter how many operators it has.
+ * The pipeline returns immediately when its sink is a subject without observers.
+ *
+ * \see pg::pipe
+ */
+template< typename In, typename ...S >
+class pipeline;
+
+template< typename ...In, typename ...S >
+class pipeline< void( In... ), S... >
+{
+    static constexpr std::size_t last = sizeof...( S ) - 1;
+
+    std::tuple< S... > m_stages;
+
+    template< std::size_t I, typename ...V >
+    void run( std::true_type, V&&... values )
+    {
+        detail::call_sink( std::get< I >( m_stages ), std::forward< V >( values )... );
+    }
+
+    template< std::size_t I, typename ...V >
+    void run( std::false_type, V&&... values )
+    {
+        std::get< I >( m_stages )( [ this ]( auto&&... next_values )
+        {
+            this->template run< I + 1 >( std::integral_constant< bool, I + 1 == last >(), std::forward< decltype( next_values ) >( next_values )... );
+        }, std::forward< V >( values )... );
+    }
+
+public:
+    explicit pipeline( S... stages )
+            : m_stages( std::move( stages )... )
+    {}
+
+    void operator()( In... args )
+    {
+        if( detail::sink_active( std::get< last >( m_stages ) ) )
+        {
+            run< 0 >( std::integral_constant< bool, last == 0 >(), std::forward< In >( args )... );
+        }
+    }
+};
+
+/**
+ * \brief Creates a pipeline of operators that ends in a sink.
+ *
+ * \tparam In The types of the values of the subject to which the pipeline is connected.
+ *
+ * \param stages The operators, like pg::map and pg::filter, followed by the sink.
+ *               The sink is a callable or a subject that is wrapped by pg::into.
+ *
+ * \return Returns a callable that can be connected to a subject.
+ *
+ * \code
+ * pg::subject< int > source;
+ * pg::subject< int > doubled;
+ *
+ * auto c = pg::connect( source, pg::pipe< int >( pg::map( []( int i ){ return i * 2; } ),
+ *                                                pg::filter( []( int i ){ return i > 3; } ),
+ *                                                pg::into( doubled ) ) );
+ * \endcode
+ */
+template< typename ...In, typename ...S >
+inline pipeline< void( In... ), typename std::decay< S >::type... > pipe( S&&... stages )
+{
+    static_assert( sizeof...( S ) > 0, "A pipeline needs at least a sink." );
+    return pipeline< void( In... ), typename std::decay< S >::type... >( std::forward< S >( stages )... );
+}
+
+/**
+ * \brief An operator that passes the value that the function returns for a notification.
+ */
+template< typename F >
+inline detail::map_stage< typename std::decay< F >::type > map( F&& function )
+{
+    return detail::map_stage< typename std::decay< F >::type >( std::forward< F >( function ) );
+}
+
+/**
+ * \brief An operator that passes the notifications for which the predicate returns true.
+ */
+template< typename F >
+inline detail::filter_stage< typename std::decay< F >::type > filter( F&& predicate )
+{
+    return detail::filter_stage< typename std::decay< F >::type >( std::forward< F >( predicate ) );
+}
+
+/**
+ * \brief An operator that passes a value only when it differs from the previous value it passed.
+ *
+ * \tparam T The type of the value which must be equality comparable.
+ */
+template< typename T >
+inline detail::distinct_stage< T > distinct_until_changed() noexcept
+{
+    return detail::distinct_stage< T >();
+}
+
+/**
+ * \brief An operator that passes every \em interval th notification.
+ */
+inline detail::sample_stage sample( const std::size_t interval ) noexcept
+{
+    return detail::sample_stage( interval );
+}
+
+/**
+ * \brief An operator that passes a notification and drops the notifications that follow within \em interval.
+ */
+inline detail::throttle_stage throttle( const std::chrono::steady_clock::duration interval ) noexcept
+{
+    return detail::throttle_stage( interval );
+}
+
+/**
+ * \brief A sink for a pipeline that notifies a subject.
+ *
+ * The pipeline skips all its operators while the subject has no observers.
+ */
+template< typename S >
+inline detail::subject_sink< S > into( S &s ) noexcept
+{
+    return detail::subject_sink< S >( s );
+}
+
+}
@@ -0,0 +1,100 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <thread>
+#include <vector>
+
+namespace pg
+{
+
+/**
+ * \brief A policy for pg::subject::notify_parallel that splits the observers in chunks and notifies each chunk on its own thread.
+ *
+ * The calling thread notifies the first chunk and waits for the threads of the other chunks.
+ * Chunks for which no thread can be started are notified by the calling thread.
+ * Observers that are notified on other threads than the calling thread must not throw exceptions.
+ */
+struct parallel_threads
+{
+    std::size_t threshold  = 1024;  ///< The minimum number of observers to notify in parallel.
+    std::size_t chunk_size = 256;   ///< The minimum number of observers per thread.
+    unsigned    threads    = 0;     ///< The maximum number of threads including the calling thread, 0 uses std::thread::hardware_concurrency.
+
+    template< typename F >
+    void run( const std::size_t count, const F &task ) const
+    {
+        const unsigned    concurrency = threads ? threads : std::thread::hardware_concurrency();
+        const std::size_t max_chunks  = chunk_size ? ( count + chunk_size - 1 ) / chunk_size : count;
+        const std::size_t chunks      = concurrency < max_chunks ? concurrency : max_chunks;
+        if( chunks < 2 )
+        {
+            task( 0, count );
+            return;
+        }
+
+        const std::size_t size = ( count + chunks - 1 ) / chunks;
+
+        std::vector< std::thread > workers;
+        std::size_t first = size;
+        try
+        {
+            workers.reserve( chunks - 1 );
+            for( ; first < count ; first += size )
+            {
+                const std::size_t last = first + size < count ? first + size : count;
+                workers.emplace_back( [ &task, first, last ]{ task( first, last ); } );
+            }
+        }
+        catch( ... )
+        {
+        }
+
+        const auto join = [ &workers ]
+        {
+            for( auto &w : workers )
+            {
+                w.join();
+            }
+        };
+
+        try
+        {
+            task( 0, size );
+            for( ; first < count ; first += size )
+            {
+                task( first, first + size < count ? first + size : count );
+            }
+        }
+        catch( ... )
+        {
+            join();
+            throw;
+        }
+
+        join();
+    }
+};
+
+}
@@ -0,0 +1,380 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <tuple>
+#include <utility>
+
+namespace pg
+{
+
+/**
+ * \brief Defines what pg::queued_subject::notify does when the queue is full.
+ */
+enum class overflow_policy
+{
+    block,          ///< Wait until the queue has room for the notification.
+    drop_oldest,    ///< Discard the oldest notification in the queue.
+    coalesce        ///< Replace the newest notification in the queue so that the latest values are always delivered.
+};
+
+/**
+ * \brief A subject that queues its notifications and notifies its observers when the queue is dispatched.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions.
+ *
+ * Notify copies or moves the values into a bounded queue and returns without calling the observers.
+ * The observers are called by the thread that dispatches the queue, this is one of the following;
+ * - A thread that calls dispatch.
+ * - A worker thread that calls run until stop is called.
+ * - The executor passed at construction, which receives a task that dispatches the queue each time the queue got notifications.
+ *
+ * Notify may be called from any thread.
+ * The queue is dispatched by one thread at a time so that the observers are called in the order of the notifications,
+ * the executor may run its tasks concurrently on different threads.
+ * Connecting and disconnecting observers must be done on the thread that dispatches or when the queue is not dispatched.
+ * The values are stored as their decayed types, a subject of const std::string & stores a std::string.
+ *
+ * \see pg::overflow_policy
+ */
+template< typename ...A >
+class queued_subject : public detail::subject_base< A... >
+{
+public:
+    /**
+     * \brief A function that runs the given task, for example by posting it to a thread pool.
+     */
+    using executor = std::function< void( std::function< void() > ) >;
+
+private:
+    queued_subject( const queued_subject< A... > & ) = delete;
+    queued_subject< A... >& operator=( const queued_subject< A... > & ) = delete;
+
+    using event = std::tuple< typename std::decay< A >::type... >;
+
+    // Shared with the tasks of the executor so that a task that runs after the destruction of the subject does nothing.
+    struct executor_state
+    {
+        executor                exec;
+        std::mutex              mutex;
+        queued_subject< A... > *subject;
+    };
+
+    const std::size_t                       m_capacity;
+    const overflow_policy                   m_policy;
+    const std::shared_ptr< executor_state > m_executor;
+    std::mutex                              m_mutex;
+    std::condition_variable                 m_not_full;
+    std::condition_variable                 m_not_empty;
+    std::condition_variable                 m_idle;
+    std::deque< event >                     m_queue;
+    std::thread::id                         m_dispatcher;
+    std::size_t                             m_running   = 0;
+    bool                                    m_scheduled = false;
+    bool                                    m_stopped   = false;
+
+    // Ends a dispatch or a run under the lock and wakes the threads that wait for it, also when an observer throws.
+    class idle_guard
+    {
+        using release_function = void ( queued_subject< A... >::* )();
+
+        queued_subject< A... >          &m_subject;
+        std::unique_lock< std::mutex >  &m_lock;
+        const release_function          m_release;
+
+    public:
+        idle_guard( queued_subject< A... > &subject, std::unique_lock< std::mutex > &lock, const release_function release ) noexcept
+            : m_subject( subject )
+            , m_lock( lock )
+            , m_release( release )
+        {}
+
+        ~idle_guard() noexcept
+        {
+            if( !m_lock.owns_lock() )
+            {
+                m_lock.lock();
+            }
+            ( m_subject.*m_release )();
+            m_subject.m_idle.notify_all();
+        }
+    };
+
+    void end_dispatch() noexcept
+    {
+        m_dispatcher = std::thread::id();
+    }
+
+    void end_run() noexcept
+    {
+        --m_running;
+    }
+
+    static std::shared_ptr< executor_state > make_executor_state( executor exec, queued_subject< A... > *subject )
+    {
+        if( !exec )
+        {
+            return nullptr;
+        }
+
+        auto state     = std::make_shared< executor_state >();
+        state->exec    = std::move( exec );
+        state->subject = subject;
+        return state;
+    }
+
+    static void schedule( const std::shared_ptr< executor_state > &state )
+    {
+        state->exec( [ state ]
+        {
+            bool reschedule = false;
+            {
+                std::lock_guard< std::mutex > lock( state->mutex );
+                if( state->subject )
+                {
+                    reschedule = state->subject->dispatch_task();
+                }
+            }
+            if( reschedule )
+            {
+                schedule( state );
+            }
+        } );
+    }
+
+    template< std::size_t ...I >
+    void notify_observers( event &e, std::index_sequence< I... > )
+    {
+        const typename detail::subject_base< A... >::notification n( *this );
+        for( const auto &s : detail::subject_base< A... >::observers() )
+        {
+            if( s.o ) PG_OBSERVER_LIKELY
+            {
+                s.notify( s.o, std::get< I >( e )... );
+            }
+        }
+    }
+
+    // Takes the queued notifications and notifies the observers without holding the lock.
+    // One thread dispatches at a time so that the observers are called in the order of the notifications.
+    // A dispatch by an observer of the thread that is dispatching returns without dispatching.
+    std::size_t dispatch_queue( std::unique_lock< std::mutex > &lock )
+    {
+        const auto self = std::this_thread::get_id();
+        if( m_dispatcher == self )
+        {
+            return 0;
+        }
+
+        m_idle.wait( lock, [ this ]{ return m_dispatcher == std::thread::id(); } );
+        if( m_queue.empty() )
+        {
+            return 0;
+        }
+
+        std::deque< event > events;
+        events.swap( m_queue );
+        m_dispatcher = self;
+
+        const idle_guard guard( *this, lock, &queued_subject< A... >::end_dispatch );
+        lock.unlock();
+        m_not_full.notify_all();
+
+        for( auto &e : events )
+        {
+            notify_observers( e, std::index_sequence_for< A... >() );
+        }
+
+        return events.size();
+    }
+
+    // Returns true when the executor must run a task that dispatches the notifications that were queued while dispatching.
+    bool dispatch_task()
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        dispatch_queue( lock );
+        m_scheduled = !m_stopped && !m_queue.empty() && m_dispatcher == std::thread::id();
+        return m_scheduled;
+    }
+
+public:
+    /**
+     * \param capacity The maximum number of notifications in the queue.
+     * \param policy   Defines what notify does when the queue is full.
+     * \param exec     An optional executor that dispatches the queue.
+     */
+    explicit queued_subject( std::size_t capacity, overflow_policy policy = overflow_policy::block, executor exec = executor() )
+            : m_capacity( capacity ? capacity : 1 )
+            , m_policy( policy )
+            , m_executor( make_executor_state( std::move( exec ), this ) )
+    {}
+
+    /**
+     * Waits until the threads that dispatch or run return.
+     * Tasks of the executor that did not start yet do nothing when they run after the destruction.
+     */
+    ~queued_subject() noexcept
+    {
+        stop();
+
+        if( m_executor )
+        {
+            std::lock_guard< std::mutex > lock( m_executor->mutex );
+            m_executor->subject = nullptr;
+        }
+
+        std::unique_lock< std::mutex > lock( m_mutex );
+        m_idle.wait( lock, [ this ]{ return m_dispatcher == std::thread::id() && m_running == 0; } );
+    }
+
+    /**
+     * \brief Queues a notification for the observers.
+     *
+     * \param args The values passed to the observer's notification function when the queue is dispatched.
+     *
+     * \return Returns false when the subject is stopped, true otherwise.
+     *
+     * \note Calling notify with the block policy from the thread that dispatches the queue deadlocks when the queue is full.
+     */
+    bool notify( A... args )
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+
+        if( !m_stopped && m_queue.size() >= m_capacity )
+        {
+            switch( m_policy )
+            {
+            case overflow_policy::block:
+                m_not_full.wait( lock, [ this ]{ return m_stopped || m_queue.size() < m_capacity; } );
+                break;
+
+            case overflow_policy::drop_oldest:
+                m_queue.pop_front();
+                break;
+
+            case overflow_policy::coalesce:
+                m_queue.back() = event( std::forward< A >( args )... );
+                return true;
+            }
+        }
+
+        if( m_stopped )
+        {
+            return false;
+        }
+
+        m_queue.emplace_back( std::forward< A >( args )... );
+
+        const bool schedule_task = m_executor && !m_scheduled;
+        m_scheduled              = m_scheduled || schedule_task;
+        lock.unlock();
+
+        if( schedule_task )
+        {
+            schedule( m_executor );
+        }
+        else
+        {
+            m_not_empty.notify_one();
+        }
+
+        return true;
+    }
+
+    /**
+     * \brief Notifies the observers with the queued notifications on the calling thread.
+     *
+     * \return Returns the number of notifications that were dispatched.
+     *
+     * Notifications that are queued while dispatching are dispatched by the next dispatch.
+     * Dispatch waits when another thread is dispatching and returns 0 when it is called by an observer.
+     */
+    std::size_t dispatch()
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        const std::size_t count = dispatch_queue( lock );
+
+        // Notifications that were queued by an observer during this dispatch are left to the executor.
+        const bool schedule_task = m_executor && !m_scheduled && !m_stopped && !m_queue.empty() && m_dispatcher == std::thread::id();
+        m_scheduled              = m_scheduled || schedule_task;
+        lock.unlock();
+
+        if( schedule_task )
+        {
+            schedule( m_executor );
+        }
+
+        return count;
+    }
+
+    /**
+     * \brief Dispatches the notifications of the queue until stop is called.
+     *
+     * This function is meant to run on a worker thread.
+     */
+    void run()
+    {
+        std::unique_lock< std::mutex > lock( m_mutex );
+        ++m_running;
+        const idle_guard guard( *this, lock, &queued_subject< A... >::end_run );
+        while( !m_stopped )
+        {
+            m_not_empty.wait( lock, [ this ]{ return m_stopped || !m_queue.empty(); } );
+            dispatch_queue( lock );
+        }
+    }
+
+    /**
+     * \brief Stops run and notify.
+     *
+     * Notifications that are queued after stop are discarded.
+     * Notifications that are already queued can still be dispatched with dispatch.
+     */
+    void stop() noexcept
+    {
+        {
+            std::lock_guard< std::mutex > lock( m_mutex );
+            m_stopped = true;
+        }
+        m_not_empty.notify_all();
+        m_not_full.notify_all();
+    }
+
+    /**
+     * \brief Returns the number of queued notifications.
+     */
+    std::size_t size()
+    {
+        std::lock_guard< std::mutex > lock( m_mutex );
+        return m_queue.size();
+    }
+};
+
+}
@@ -0,0 +1,613 @@
+// MIT License
+//
+// Copyright (c) 2020 PG1003
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files (the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "observer.h"
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <tuple>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace pg
+{
+
+namespace detail
+{
+
+template< typename S, typename ...A >
+class basic_recorded_subject;
+
+template< typename ...T >
+struct payload_size
+{
+    static constexpr std::size_t value = 0;
+};
+
+template< typename T, typename ...Ts >
+struct payload_size< T, Ts... >
+{
+    static constexpr std::size_t value = sizeof( T ) + payload_size< Ts... >::value;
+};
+
+template< typename ...T >
+struct all_trivially_copyable : std::true_type
+{};
+
+template< typename T, typename ...Ts >
+struct all_trivially_copyable< T, Ts... > : std::integral_constant< bool, std::is_trivially_copyable< T >::value &&
+                                                                          all_trivially_copyable< Ts... >::value >
+{};
+
+inline std::uint64_t steady_clock_nanoseconds() noexcept
+{
+    return static_cast< std::uint64_t >( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() );
+}
+
+// Blocked subjects are not recorded because their notifications don't reach the observers.
+template< typename ...A >
+inline bool is_blocked( const subject_base< A... > & ) noexcept
+{
+    return false;
+}
+
+template< typename ...A >
+inline bool is_blocked( const blockable_subject< A... > &s ) noexcept
+{
+    return s.is_blocked();
+}
+
+}
+
+/**
+ * \brief Records the notifications of recorded subjects in a ring buffer and replays them.
+ *
+ * Each event holds a timestamp, the id of the subject and a copy of the values, which must be trivially copyable.
+ * The events are stored in a ring buffer that is allocated once; when the buffer is full the oldest events are overwritten.
+ *
+ * Notifications of recorded subjects by observers of another recorded notification are recorded as nested.
+ * Replay notifies the subjects only with the events that are not nested since the nested events are notified again
+ * by the observers of the replayed events.
+ *
+ * The recorder is not thread safe; the subjects that it records must be notified on one thread at a time.
+ *
+ * \see pg::recorded_subject pg::recorded_blockable_subject
+ */
+class event_recorder
+{
+public:
+    /**
+     * \brief A function that returns the timestamp of an event, the default returns the time of std::chrono::steady_clock in nanoseconds.
+     *
+     * Reading the clock is the largest part of the cost of recording an event.
+     * Without a clock function the events are numbered instead, or pass a function that reads a cheaper clock such as the CPU's time stamp counter.
+     */
+    using clock_function = std::uint64_t ( * )();
+
+    /**
+     * \brief A recorded event that is passed to the function of for_each.
+     */
+    struct event
+    {
+        std::uint64_t timestamp;    ///< The timestamp from the recorder's clock function, or the number of the event when the recorder has no clock function.
+        std::uint32_t subject;      ///< The id of the subject.
+        bool          nested;       ///< True when the subject was notified while another recorded notification was in progress.
+        const void    *data;        ///< The values of the notification, the values are stored one after the other without padding.
+        std::size_t   size;         ///< The size of the values in bytes.
+    };
+
+private:
+    event_recorder( const event_recorder & ) = delete;
+    event_recorder & operator=( const event_recorder & ) = delete;
+
+    template< typename S, typename ...A >
+    friend class detail::basic_recorded_subject;
+
+    // The events are stored as a header and the values rounded up to a multiple of the header size so that
+    // the remaining space at the end of the buffer always fits a padding header.
+    struct header
+    {
+        std::uint64_t timestamp;
+        std::uint32_t subject;
+        std::uint16_t size;
+        std::uint16_t flags;
+    };
+
+    static constexpr std::uint16_t nested_flag  = 1;
+    static constexpr std::uint16_t padding_flag = 2;    // The rest of the buffer is empty, the next event is at the start of the buffer.
+
+    static constexpr std::size_t record_size( const std::size_t size ) noexcept
+    {
+        return ( sizeof( header ) + size + sizeof( header ) - 1 ) / sizeof( header ) * sizeof( header );
+    }
+
+    struct source
+    {
+        void * subject;
+        void ( *replay )( void * subject, const unsigned char * data );
+        void ( *detach )( void * subject ) noexcept;
+    };
+
+    const std::size_t                             m_capacity;
+    const std::unique_ptr< unsigned char[] >      m_buffer;
+    const clock_function                          m_clock;
+    std::size_t                                   m_read        = 0;    // The offset of the oldest event.
+    std::size_t                                   m_write       = 0;    // The offset of the next event.
+    std::size_t                                   m_used        = 0;
+    std::size_t                                   m_events      = 0;
+    std::uint64_t                                 m_overwritten = 0;
+    std::uint64_t                                 m_sequence    = 0;
+    unsigned                                      m_nesting     = 0;
+    bool                                          m_replaying   = false;
+    std::unordered_map< std::uint32_t, source >   m_sources;
+
+    header read_header( const std::size_t offset ) const noexcept
+    {
+        header h;
+        std::memcpy( &h, m_buffer.get() + offset, sizeof( h ) );
+        return h;
+    }
+
+    std::size_t length( const std::size_t offset, const header &h ) const noexcept
+    {
+        return h.flags & padding_flag ? m_capacity - offset : record_size( h.size );
+    }
+
+    // Overwrites the oldest events until there is room for the given number of bytes.
+    void make_room( const std::size_t size ) noexcept
+    {
+        while( m_used + size > m_capacity )
+        {
+            const header h      = read_header( m_read );
+            const std::size_t n = length( m_read, h );
+            if( !( h.flags & padding_flag ) )
+            {
+                --m_events;
+                ++m_overwritten;
+            }
+            m_used -= n;
+            m_read  = m_read + n == m_capacity ? 0 : m_read + n;
+        }
+    }
+
+    // Returns where the values of a new event are stored, or nullptr when the event is larger than the buffer.
+    unsigned char * allocate( const std::uint64_t timestamp, const std::uint32_t subject, const std::size_t size, const std::uint16_t flags ) noexcept
+    {
+        const std::size_t n = record_size( size );
+        if( n > m_capacity )
+        {
+            ++m_overwritten;
+            return nullptr;
+        }
+
+        const std::size_t rest = m_capacity - m_write;
+        if( rest < n )
+        {
+            make_room( rest );
+            const header padding = { 0, 0, 0, padding_flag };
+            std::memcpy( m_buffer.get() + m_write, &padding, sizeof( padding ) );
+            m_used  += rest;
+            m_write  = 0;
+        }
+
+        make_room( n );
+        const header h = { timestamp, subject, static_cast< std::uint16_t >( size ), flags };
+        unsigned char * const p = m_buffer.get() + m_write;
+        std::memcpy( p, &h, sizeof( h ) );
+
+        m_used  += n;
+        m_write  = m_write + n == m_capacity ? 0 : m_write + n;
+        ++m_events;
+        return p + sizeof( header );
+    }
+
+    template< typename T >
+    static void write_value( unsigned char *&data, const T &value ) noexcept
+    {
+        std::memcpy( data, std::addressof( value ), sizeof( T ) );
+        data += sizeof( T );
+    }
+
+    template< typename ...T >
+    void write( const std::uint32_t subject, const T &... values ) noexcept
+    {
+        static_assert( detail::payload_size< T... >::value <= UINT16_MAX, "the values of a recorded notification are too large" );
+
+        unsigned char * data = allocate( m_clock ? m_clock() : ++m_sequence, subject, detail::payload_size< T... >::value, m_nesting ? nested_flag : 0 );
+        if( data )
+        {
+            const int expand[] = { 0, ( write_value( data, values ), 0 )... };
+            ( void )expand;
+        }
+    }
+
+    // Records a notification and keeps track of the nesting of recorded notifications while it is in scope.
+    class recording
+    {
+        event_recorder &m_recorder;
+
+        recording( const recording & ) = delete;
+        recording & operator=( const recording & ) = delete;
+
+    public:
+        template< typename ...T >
+        recording( event_recorder &recorder, const std::uint32_t subject, const T &... values ) noexcept
+                : m_recorder( recorder )
+        {
+            if( !m_recorder.m_replaying )
+            {
+                m_recorder.write( subject, values... );
+            }
+            ++m_recorder.m_nesting;
+        }
+
+        ~recording() noexcept
+        {
+            --m_recorder.m_nesting;
+        }
+    };
+
+    void remove( const std::uint32_t id, const void * const subject ) noexcept
+    {
+        const auto it = m_sources.find( id );
+        if( it != m_sources.end() && it->second.subject == subject )
+        {
+            m_sources.erase( it );
+        }
+    }
+
+    template< typename F >
+    void visit( F &&function ) const
+    {
+        std::size_t offset = m_read;
+        for( std::size_t used = 0 ; used < m_used ; )
+        {
+            const header h      = read_header( offset );
+            const std::size_t n = length( offset, h );
+            if( !( h.flags & padding_flag ) )
+            {
+                function( h, m_buffer.get() + offset + sizeof( header ) );
+            }
+            used   += n;
+            offset  = offset + n == m_capacity ? 0 : offset + n;
+        }
+    }
+
+public:
+    /**
+     * \param capacity The size of the ring buffer in bytes.
+     * \param clock    The function that returns the timestamps of the events, nullptr numbers the events instead.
+     *
+     * An event takes 16 bytes and the size of its values, rounded up to a multiple of 16 bytes.
+     */
+    explicit event_recorder( const std::size_t capacity, const clock_function clock = &detail::steady_clock_nanoseconds )
+            : m_capacity( record_size( capacity ) - sizeof( header ) )
+            , m_buffer( new unsigned char[ m_capacity ? m_capacity : 1 ] )
+            , m_clock( clock )
+    {}
+
+    ~event_recorder() noexcept
+    {
+        for( const auto &s : m_sources )
+        {
+            s.second.detach( s.second.subject );
+        }
+    }
+
+    /**
+     * \brief Starts recording the notifications of a subject.
+     *
+     * \param s  A recorded subject.
+     * \param id The id of the subject in the events, the id must be unique for this recorder.
+     *
+     * The id identifies the subject when the events are replayed, also when the events are loaded in another process.
+     * A subject that is recorded by another recorder or with another id is moved to this recorder and id.
+     * A subject that was recorded with the same id is no longer recorded.
+     */
+    template< typename S, typename ...A >
+    void record( detail::basic_recorded_subject< S, A... > &s, const std::uint32_t id )
+    {
+        using subject_type = detail::basic_recorded_subject< S, A... >;
+
+        s.stop_recording();
+
+        const auto it = m_sources.find( id );
+        if( it != m_sources.end() )
+        {
+            it->second.detach( it->second.subject );
+        }
+
+        m_sources[ id ] = { &s, &subject_type::replay_event, &subject_type::detach };
+        s.m_recorder    = this;
+        s.m_id          = id;
+    }
+
+    /**
+     * \brief Replays the events that are not nested on the subjects that are recorded with the ids of the events.
+     *
+     * \return Returns the number of replayed events.
+     *
+     * Events of ids without a subject are skipped.
+     * The notifications of the replay are not recorded.
+     */
+    std::size_t replay()
+    {
+        struct replay_state
+        {
+            bool &replaying;
+
+            ~replay_state() noexcept
+            {
+                replaying = false;
+            }
+        } state{ m_replaying };
+        m_replaying = true;
+
+        std::size_t replayed = 0;
+        visit( [ & ]( const header &h, const unsigned char * const data )
+        {
+            if( !( h.flags & nested_flag ) )
+            {
+                const auto it = m_sources.find( h.subject );
+                if( it != m_sources.end() )
+                {
+                    it->second.replay( it->second.subject, data );
+                    ++replayed;
+                }
+            }
+        } );
+        return replayed;
+    }
+
+    /**
+     * \brief Calls a function with each event from the oldest to the newest event.
+     *
+     * \param function A callable that takes a const event_recorder::event &.
+     */
+    template< typename F >
+    void for_each( F &&function ) const
+    {
+        visit( [ &function ]( const header &h, const unsigned char * const data )
+        {
+            const event e = { h.timestamp, h.subject, ( h.flags & nested_flag ) != 0, data, h.size };
+            function( e );
+        } );
+    }
+
+    /**
+     * \brief Returns the events from the oldest to the newest event in a binary format that can be loaded with load.
+     */
+    std::vector< unsigned char > save() const
+    {
+        std::vector< unsigned char > data;
+        data.reserve( m_used );
+        visit( [ &data ]( const header &h, const unsigned char * const values )
+        {
+            const auto first = values - sizeof( header );
+            data.insert( data.end(), first, first + record_size( h.size ) );
+        } );
+        return data;
+    }
+
+    /**
+     * \brief Replaces the events by the events that were saved with save.
+     *
+     * \param data The saved events.
+     * \param size The size of the saved events in bytes.
+     *
+     * \return Returns false when the data is not saved by an event_recorder, the events until the invalid data are loaded.
+     *
+     * The oldest events are overwritten when the events don't fit in the buffer.
+     */
+    bool load( const void * const data, const std::size_t size ) noexcept
+    {
+        clear();
+
+        const auto * p = static_cast< const unsigned char * >( data );
+        for( std::size_t offset = 0 ; offset < size ; )
+        {
+            header h;
+            if( size - offset < sizeof( h ) )
+            {
+                return false;
+            }
+
+            std::memcpy( &h, p + offset, sizeof( h ) );
+            const std::size_t n = record_size( h.size );
+            if( ( h.flags & padding_flag ) || size - offset < n )
+            {
+                return false;
+            }
+
+            unsigned char * const values = allocate( h.timestamp, h.subject, h.size, h.flags );
+            if( values )
+            {
+                std::memcpy( values, p + offset + sizeof( h ), h.size );
+            }
+            offset += n;
+        }
+        return true;
+    }
+
+    /**
+     * \brief Removes all events.
+     */
+    void clear() noexcept
+    {
+        m_read        = 0;
+        m_write       = 0;
+        m_used        = 0;
+        m_events      = 0;
+        m_overwritten = 0;
+    }
+
+    /**
+     * \brief Returns the number of events in the buffer.
+     */
+    std::size_t size() const noexcept
+    {
+        return m_events;
+    }
+
+    /**
+     * \brief Returns the number of events that were overwritten or didn't fit in the buffer since the last clear.
+     */
+    std::uint64_t overwritten() const noexcept
+    {
+        return m_overwritten;
+    }
+};
+
+namespace detail
+{
+
+// Adds recording to the notify function of subject S.
+template< typename S, typename ...A >
+class basic_recorded_subject : public S
+{
+    static_assert( all_trivially_copyable< typename std::decay< A >::type... >::value, "the values of a recorded subject must be trivially copyable" );
+
+    friend class pg::event_recorder;
+
+    event_recorder * m_recorder = nullptr;
+    std::uint32_t    m_id       = 0;
+
+    template< typename T >
+    static T read_value( const unsigned char *&data ) noexcept
+    {
+        typename std::aligned_storage< sizeof( T ), alignof( T ) >::type storage;
+        std::memcpy( &storage, data, sizeof( T ) );
+        data += sizeof( T );
+        return *reinterpret_cast< T * >( &storage );
+    }
+
+    template< typename T, std::size_t ...I >
+    void replay( const T &values, std::index_sequence< I... > )
+    {
+        notify( std::get< I >( values )... );
+    }
+
+    static void replay_event( void * const subject, const unsigned char * data )
+    {
+        std::tuple< typename std::decay< A >::type... > values{ read_value< typename std::decay< A >::type >( data )... };
+        ( void )data;
+        static_cast< basic_recorded_subject * >( subject )->replay( values, std::index_sequence_for< A... >() );
+    }
+
+    static void detach( void * const subject ) noexcept
+    {
+        static_cast< basic_recorded_subject * >( subject )->m_recorder = nullptr;
+    }
+
+    void stop_recording() noexcept
+    {
+        if( m_recorder )
+        {
+            m_recorder->remove( m_id, this );
+            m_recorder = nullptr;
+        }
+    }
+
+protected:
+    basic_recorded_subject() noexcept = default;
+
+    ~basic_recorded_subject() noexcept
+    {
+        stop_recording();
+    }
+
+public:
+    /**
+     * \brief Notifies the observers and records the notification when the subject is recorded.
+     *
+     * \param args The values passed to the observer's notification function.
+     */
+    void notify( A... args ) const
+    {
+        if( m_recorder && !is_blocked( *this ) )
+        {
+            const event_recorder::recording r( *m_recorder, m_id, args... );
+            S::notify( std::forward< A >( args )... );
+        }
+        else
+        {
+            S::notify( std::forward< A >( args )... );
+        }
+    }
+
+    /**
+     * \brief Stops recording the notifications of this subject, see pg::event_recorder::record.
+     */
+    void stop() noexcept
+    {
+        stop_recording();
+    }
+
+    /**
+     * \brief Returns true when the notifications of this subject are recorded.
+     */
+    bool recording() const noexcept
+    {
+        return m_recorder != nullptr;
+    }
+};
+
+}
+
+/**
+ * \brief A pg::subject of which the notifications can be recorded by a pg::event_recorder.
+ *
+ * \tparam A The types of the values that are passed to the observers notification functions, their decayed types must be trivially copyable.
+ *
+ * When the subject is not recorded, notify tests one pointer before it notifies like pg::subject.
+ * Other subjects are not recorded and don't pay for it.
+ * Only notify is recorded, not notify_batch and notify_parallel.
+ *
+ * \see pg::event_recorder pg::subject
+ */
+template< typename ...A >
+class recorded_subject : public detail::basic_recorded_subject< subject< A... >, A... >
+{
+public:
+    recorded_subject() noexcept = default;
+};
+
+/**
+ * \brief A pg::blockable_subject of which the notifications can be recorded by a pg::event_recorder.
+ *
+ * Notifications while the subject is blocked are not recorded.
+ *
+ * \see pg::event_recorder pg::blockable_subject
+ */
+template< typename ...A >
+class recorded_blockable_subject : public detail::basic_recorded_subject< blockable_subject< A... >, A... >
+{
+public:
+    recorded_blockable_subject() noexcept = default;
+};
+
+}
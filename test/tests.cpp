@@ -1,12 +1,28 @@
 #include <observer.h>
+#include <concurrent_subject.h>
+#include <queued_subject.h>
+#include <parallel_notify.h>
+#include <instrumented_subject.h>
+#include <event_bus.h>
+#include <channel.h>
+#include <operators.h>
+#include <awaitable.h>
+#include <fixed_subject.h>
+#include <erased_subject.h>
+#include <recorded_subject.h>
 #include <iostream>
 #include <string>
 #if __cplusplus >= 201703L
 #include <string_view>
 #endif
 #include <vector>
+#include <algorithm>
 #include <functional>
 #include <memory>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <cstring>
 
 static int total_asserts  = 0;
 static int failed_asserts = 0;
@@ -571,6 +587,2186 @@ static void observer_notify_and_disconnect_order()
     s.notify();
 }
 
+static void disconnect_keeps_order()
+{
+    subject< std::vector< int > & > s;
+    connection_owner                owner;
+
+    std::vector< connection_owner::connection > connections;
+    for( int i = 0 ; i < 100 ; ++i )
+    {
+        connections.push_back( owner.connect( s, [ i ]( std::vector< int > &v ){ v.push_back( i ); } ) );
+    }
+
+    // Disconnect all but the multiples of 10; handles remain valid after the containers are compacted.
+    for( int i = 0 ; i < 100 ; ++i )
+    {
+        if( i % 10 )
+        {
+            owner.disconnect( connections[ i ] );
+        }
+    }
+
+    // Disconnecting twice has no effect.
+    owner.disconnect( connections[ 1 ] );
+
+    std::vector< int > values;
+    s.notify( values );
+    assert_true( ( values == std::vector< int >{ 0, 10, 20, 30, 40, 50, 60, 70, 80, 90 } ) );
+
+    owner.disconnect( connections[ 50 ] );
+    values.clear();
+    s.notify( values );
+    assert_true( ( values == std::vector< int >{ 0, 10, 20, 30, 40, 60, 70, 80, 90 } ) );
+
+    // A custom observer that is connected to multiple subjects.
+    struct count_observer final : public observer<>
+    {
+        int m_count = 0;
+
+        virtual void notify() override { ++m_count; }
+        virtual void disconnect() noexcept override {}
+    };
+
+    count_observer o;
+    subject<>      s1;
+    subject<>      s2;
+    auto           c = connect( s1, []{} );
+
+    s1.connect( &o );
+    s2.connect( &o );
+    s1.disconnect( &o );
+
+    s1.notify();
+    s2.notify();
+    assert_true( o.m_count == 1 );
+
+    s2.disconnect( &o );
+    s2.notify();
+    assert_true( o.m_count == 1 );
+}
+
+static void observer_notify_function()
+{
+    struct direct_observer final : public observer< int >
+    {
+        int m_direct  = 0;
+        int m_virtual = 0;
+
+        static void notify_direct( observer< int > * const o, int i )
+        {
+            static_cast< direct_observer * >( o )->m_direct += i;
+        }
+
+        virtual notify_function get_notify_function() const noexcept override
+        {
+            return &direct_observer::notify_direct;
+        }
+
+        virtual void notify( int i ) override { m_virtual += i; }
+        virtual void disconnect() noexcept override {}
+    };
+
+    direct_observer o;
+
+    {
+        subject< int > s;
+        s.connect( &o );
+
+        s.notify( 2 );
+        assert_true( o.m_direct == 2 );
+        assert_true( o.m_virtual == 0 );
+    }
+
+    {
+        blockable_subject< int > s;
+        s.connect( &o );
+
+        s.notify( 3 );
+        assert_true( o.m_direct == 5 );
+        assert_true( o.m_virtual == 0 );
+    }
+}
+
+static void inline_subject_observers()
+{
+    inline_subject< int > s;
+    connection_owner      owner;
+
+    int small_val  = 0;
+    int large_val  = 0;
+    int std_val    = 0;
+    int custom_val = 0;
+
+    struct large_functor
+    {
+        int  &m_val;
+        char m_payload[ 64 ] = {};
+
+        void operator()( int i ) { m_val += i; }
+    };
+
+    struct custom_observer final : public observer< int >
+    {
+        int &m_val;
+
+        custom_observer( int &val ) noexcept
+            : m_val( val )
+        {}
+
+        virtual void notify( int i ) override { m_val += i; }
+        virtual void disconnect() noexcept override {}
+    };
+
+    member_observers                   members;
+    custom_observer                    custom( custom_val );
+    const std::function< void( int ) > std_function = [ & ]( int i ){ std_val += i; };
+
+    std::vector< connection_owner::connection > connections;
+    for( int i = 0 ; i < 100 ; ++i )
+    {
+        // Enough connections to relocate the inline copies a few times
+        connections.push_back( owner.connect( s, [ &small_val ]( int i ){ small_val += i; } ) );
+    }
+    owner.connect( s, large_functor{ large_val } );
+    owner.connect( s, std_function );
+    owner.connect( s, &members, &member_observers::int_ );
+    s.connect( &custom );
+
+    auto c = connect( s, [ count = 0, &small_val ]() mutable { small_val += ++count; } );
+
+    s.notify( 1 );
+    assert_true( small_val == 101 );
+    assert_true( large_val == 1 );
+    assert_true( std_val == 1 );
+    assert_true( members.int_ival == 1 );
+    assert_true( custom_val == 1 );
+
+    for( std::size_t i = 0 ; i < connections.size() ; ++i )
+    {
+        owner.disconnect( connections[ i ] );
+    }
+
+    // The state of the mutable lambda is maintained after it was moved by compacting the subject
+    s.notify( 2 );
+    assert_true( small_val == 103 );
+    assert_true( large_val == 3 );
+    assert_true( std_val == 3 );
+    assert_true( members.int_ival == 2 );
+    assert_true( custom_val == 3 );
+
+    c.reset();
+    s.disconnect( &custom );
+
+    s.notify( 3 );
+    assert_true( small_val == 103 );
+    assert_true( custom_val == 3 );
+    assert_true( large_val == 6 );
+}
+
+template< typename S >
+static void reentrant_notify()
+{
+    S                s;
+    connection_owner owner;
+
+    int  val = 0;
+    bool thrown = false;
+
+    scoped_connection                          self;
+    std::vector< connection_owner::connection > others;
+
+    // Disconnects the observers that are connected after it and itself.
+    // Resetting its own connection destroys the lambda, so this must be the last thing it does.
+    self = connect( s, [ & ]( int i )
+    {
+        val += i;
+        for( auto c : others )
+        {
+            owner.disconnect( c );
+        }
+        self.reset();
+    } );
+
+    for( int i = 0 ; i < 10 ; ++i )
+    {
+        others.push_back( owner.connect( s, [ & ]( int i ){ val += i * 10; } ) );
+    }
+
+    // Connects new observers while notifying, enough to reallocate the container of observers.
+    owner.connect( s, [ &, connected = false ]( int ) mutable
+    {
+        if( !connected )
+        {
+            connected = true;
+            for( int i = 0 ; i < 100 ; ++i )
+            {
+                owner.connect( s, [ & ]( int i ){ val += i * 100; } );
+            }
+        }
+    } );
+
+    s.notify( 1 );
+    assert_true( val == 1 );
+
+    val = 0;
+    s.notify( 1 );
+    assert_true( val == 10000 );
+
+    // Nested notifications
+    int depth = 0;
+    owner.connect( s, [ & ]( int i )
+    {
+        if( i > 0 )
+        {
+            ++depth;
+            s.notify( i - 1 );
+        }
+    } );
+
+    val = 0;
+    s.notify( 2 );
+    assert_true( depth == 2 );
+    assert_true( val == 30000 );
+
+    // Exceptions leave the subject in a consistent state
+    auto throwing = connect( s, [ & ]( int i ){ if( i == 42 ) throw 42; } );
+
+    try
+    {
+        s.notify( 42 );
+    }
+    catch( int )
+    {
+        thrown = true;
+    }
+    assert_true( thrown );
+
+    throwing.reset();
+    val = 0;
+    s.notify( 0 );
+    assert_true( val == 0 );
+
+    val = 0;
+    s.notify( 1 );
+    assert_true( val == 10000 );
+}
+
+static void connection_owner_pool()
+{
+    struct counted
+    {
+        int &m_sum;
+        int &m_alive;
+
+        counted( int &sum, int &alive ) noexcept
+            : m_sum( sum )
+            , m_alive( alive )
+        {
+            ++m_alive;
+        }
+
+        counted( const counted &other ) noexcept
+            : m_sum( other.m_sum )
+            , m_alive( other.m_alive )
+        {
+            ++m_alive;
+        }
+
+        ~counted()
+        {
+            --m_alive;
+        }
+
+        void operator()( int i )
+        {
+            m_sum += i;
+        }
+    };
+
+    struct large : counted
+    {
+        char m_payload[ 512 ] = {};
+
+        using counted::counted;
+    };
+
+    struct alignas( 64 ) over_aligned : counted
+    {
+        using counted::counted;
+    };
+
+    subject< int > s;
+
+    int sum   = 0;
+    int alive = 0;
+
+    {
+        connection_owner                            owner;
+        std::vector< connection_owner::connection > connections;
+
+        for( int i = 0 ; i < 1000 ; ++i )
+        {
+            connections.push_back( owner.connect( s, counted( sum, alive ) ) );
+        }
+        owner.connect( s, large( sum, alive ) );
+        owner.connect( s, over_aligned( sum, alive ) );
+        assert_true( alive == 1002 );
+
+        s.notify( 1 );
+        assert_true( sum == 1002 );
+
+        for( std::size_t i = 0 ; i < connections.size() ; i += 2 )
+        {
+            owner.disconnect( connections[ i ] );
+        }
+        assert_true( alive == 502 );
+
+        // Reuse the memory of the disconnected observers
+        for( int i = 0 ; i < 500 ; ++i )
+        {
+            owner.connect( s, counted( sum, alive ) );
+        }
+        assert_true( alive == 1002 );
+
+        sum = 0;
+        s.notify( 2 );
+        assert_true( sum == 2004 );
+    }
+
+    assert_true( alive == 0 );
+
+    sum = 0;
+    s.notify( 3 );
+    assert_true( sum == 0 );
+}
+
+static void connection_handles()
+{
+    static_assert( std::is_trivially_copyable< connection_owner::connection >::value, "connection handles must be trivially copyable" );
+
+    subject< int >   s;
+    connection_owner owner;
+
+    int a = 0;
+    int b = 0;
+
+    const auto c_a = owner.connect( s, [ & ]( int i ){ a += i; } );
+    assert_true( owner.connected( c_a ) );
+    assert_true( !owner.connected( connection_owner::connection() ) );
+
+    owner.disconnect( c_a );
+    assert_true( !owner.connected( c_a ) );
+
+    // The new connection reuses the memory and the slot of the removed one, the stale handle must not match it
+    const auto c_b = owner.connect( s, [ & ]( int i ){ b += i; } );
+    owner.disconnect( c_a );
+    assert_true( !owner.set_block_state( c_a, true ) );
+    assert_true( owner.connected( c_b ) );
+
+    s.notify( 1 );
+    assert_true( a == 0 );
+    assert_true( b == 1 );
+
+    // Handles stay valid while the connections are compacted
+    std::vector< connection_owner::connection > connections;
+    for( int i = 0 ; i < 100 ; ++i )
+    {
+        connections.push_back( owner.connect( s, [ & ]( int v ){ a += v; } ) );
+    }
+    for( std::size_t i = 0 ; i < connections.size() ; i += 3 )
+    {
+        owner.disconnect( connections[ i ] );
+    }
+    owner.disconnect( c_b );
+    for( std::size_t i = 0 ; i < connections.size() ; ++i )
+    {
+        assert_true( owner.connected( connections[ i ] ) == ( i % 3 != 0 ) );
+    }
+
+    s.notify( 1 );
+    assert_true( a == 66 );
+    assert_true( b == 1 );
+
+    // Adding a connection compacts the removed connections
+    const auto c_c = owner.connect( s, [ & ]( int i ){ b += i; } );
+    for( std::size_t i = 0 ; i < connections.size() ; ++i )
+    {
+        assert_true( owner.connected( connections[ i ] ) == ( i % 3 != 0 ) );
+    }
+    owner.disconnect( connections[ 1 ] );
+    assert_true( !owner.connected( connections[ 1 ] ) );
+    assert_true( owner.connected( c_c ) );
+
+    s.notify( 1 );
+    assert_true( a == 131 );
+    assert_true( b == 2 );
+
+    // Connections that are removed by the subject are not connected anymore
+    connection_owner::connection c_destroyed;
+    {
+        subject< int > temporary;
+        c_destroyed = owner.connect( temporary, [ & ]( int i ){ a += i; } );
+        assert_true( owner.connected( c_destroyed ) );
+    }
+    assert_true( !owner.connected( c_destroyed ) );
+    owner.disconnect( c_destroyed );
+
+    // Handles of a destroyed connection owner don't match a connection owner that is constructed at the same address
+    {
+        typename std::aligned_storage< sizeof( connection_owner ), alignof( connection_owner ) >::type storage;
+        int count = 0;
+
+        auto first = new( &storage ) connection_owner;
+        const auto c_in_range = first->connect( s, [ & ]( int i ){ count += i; } );
+        first->connect( s, [ & ]( int i ){ count += i; } );
+        const auto c_out_of_range = first->connect( s, [ & ]( int i ){ count += i; } );
+        first->~connection_owner();
+
+        auto second = new( &storage ) connection_owner;
+        second->connect( s, [ & ]( int i ){ count += i; } );
+        assert_true( !second->connected( c_in_range ) );
+        assert_true( !second->connected( c_out_of_range ) );
+        assert_true( !second->set_block_state( c_in_range, true ) );
+        second->disconnect( c_in_range );
+        second->disconnect( c_out_of_range );
+
+        s.notify( 1 );
+        assert_true( count == 1 );
+        second->~connection_owner();
+    }
+}
+
+static void empty_subjects()
+{
+    static_assert( sizeof( subject< int > ) == sizeof( void * ), "a subject without observers is one pointer" );
+    static_assert( sizeof( inline_subject< int > ) == sizeof( void * ), "a subject without observers is one pointer" );
+
+    int val = 0;
+
+    // Subjects without observers have no storage
+    subject< int > s;
+    s.notify( 1 );
+    s.notify_parallel( parallel_threads(), 1 );
+    s.sweep();
+    assert_true( s.observer_count() == 0 );
+
+    blockable_subject< int > bs;
+    bs.block();
+    bs.notify( 1 );
+    bs.unblock();
+    assert_true( bs.observer_count() == 0 );
+
+    s.reserve( 10 );
+    assert_true( s.observer_count() == 0 );
+
+    {
+        auto c1 = connect( s, [ & ]( int i ){ val += i; } );
+        auto c2 = connect( bs, [ & ]( int i ){ val += i * 10; } );
+        assert_true( s.observer_count() == 1 );
+
+        s.notify( 1 );
+        bs.notify( 1 );
+        assert_true( val == 11 );
+    }
+
+    s.notify( 1 );
+    bs.notify( 1 );
+    assert_true( val == 11 );
+    assert_true( s.observer_count() == 0 );
+    assert_true( bs.observer_count() == 0 );
+}
+
+static void connection_owner_bulk()
+{
+    subject< int > s1;
+    subject< int > s2;
+    concurrent_subject< int > s3;
+
+    int sum = 0;
+
+    std::vector< std::function< void( int ) > > functions;
+    for( int i = 0 ; i < 100 ; ++i )
+    {
+        functions.emplace_back( [ &sum, i ]( int v ){ sum += v * i; } );
+    }
+
+    {
+        connection_owner owner;
+        owner.reserve( 300 );
+        s1.reserve( 100 );
+        assert_true( s1.observer_count() == 0 );
+
+        owner.connect_all( s1, functions );
+        owner.connect_all( s2, functions );
+        owner.connect_all( s3, functions );
+        assert_true( s1.observer_count() == 100 );
+        assert_true( s2.observer_count() == 100 );
+
+        std::size_t tail = 0;
+        void ( * const tails[] )( int ) = { &free_function_int, &free_function_int };
+        owner.connect_all( s1, tails );
+        owner.connect( s1, [ & ]( int ){ ++tail; } );
+        assert_true( s1.observer_count() == 103 );
+
+        s1.notify( 1 );
+        assert_true( sum == 4950 );
+        assert_true( tail == 1 );
+
+        owner.disconnect_all( s1 );
+        assert_true( s1.observer_count() == 0 );
+
+        sum = 0;
+        s1.notify( 1 );
+        assert_true( sum == 0 );
+        assert_true( tail == 1 );
+
+        s2.notify( 2 );
+        assert_true( sum == 9900 );
+
+        sum = 0;
+        s3.notify( 1 );
+        assert_true( sum == 4950 );
+
+        owner.disconnect_all( s3 );
+
+        sum = 0;
+        s3.notify( 1 );
+        assert_true( sum == 0 );
+
+        // Reserving during a notification reserves room for the observers that are connected during the notification
+        owner.connect( s1, [ & ]( int )
+        {
+            s1.reserve( 10 );
+            owner.connect( s1, [ & ]( int ){ ++tail; } );
+        } );
+        s1.notify( 1 );
+        assert_true( s1.observer_count() == 2 );
+        assert_true( tail == 1 );
+    }
+
+    sum = 0;
+    s2.notify( 1 );
+    assert_true( sum == 0 );
+    assert_true( s2.observer_count() == 0 );
+}
+
+static void connection_owner_teardown()
+{
+    subject< int > s1;
+    blockable_subject< int > s2;
+    concurrent_subject< int > s3;
+
+    int sum   = 0;
+    int other = 0;
+
+    connection_owner survivor;
+
+    {
+        auto owner = std::make_unique< connection_owner >();
+        survivor.connect( s1, [ & ]( int v ){ other += v; } );
+        for( int i = 0 ; i < 3000 ; ++i )
+        {
+            switch( i % 3 )
+            {
+            case 0: owner->connect( s1, [ & ]( int v ){ sum += v; } ); break;
+            case 1: owner->connect( s2, [ & ]( int v ){ sum += v; } ); break;
+            case 2: owner->connect( s3, [ & ]( int v ){ sum += v; } ); break;
+            }
+        }
+        survivor.connect( s2, [ & ]( int v ){ other += v; } );
+        assert_true( s1.observer_count() == 1001 );
+        assert_true( s2.observer_count() == 1001 );
+
+        s1.notify( 1 );
+        assert_true( sum == 1000 );
+        assert_true( other == 1 );
+
+        owner.reset();
+        assert_true( s1.observer_count() == 1 );
+        assert_true( s2.observer_count() == 1 );
+
+        sum = 0;
+        s1.notify( 1 );
+        s2.notify( 1 );
+        s3.notify( 1 );
+        assert_true( sum == 0 );
+        assert_true( other == 3 );
+    }
+
+    // Destroying the owner during a notification compacts the subject when the notification returns
+    {
+        auto owner = std::make_unique< connection_owner >();
+        const auto c = survivor.connect( s1, [ & ]( int ){ owner.reset(); } );
+        for( int i = 0 ; i < 100 ; ++i )
+        {
+            owner->connect( s1, [ & ]( int v ){ sum += v; } );
+        }
+
+        other = 0;
+        s1.notify( 1 );
+        assert_true( !owner );
+        assert_true( sum == 0 );
+        assert_true( other == 1 );
+        assert_true( s1.observer_count() == 2 );
+
+        survivor.disconnect( c );
+    }
+
+    // Destroying the subjects disconnects the observers from the owner
+    {
+        connection_owner owner;
+        auto s4 = std::make_unique< subject< int > >();
+        auto s5 = std::make_unique< subject< int > >();
+        for( int i = 0 ; i < 1000 ; ++i )
+        {
+            owner.connect( i % 2 ? *s4 : *s5, [ & ]( int v ){ sum += v; } );
+        }
+        const auto c = owner.connect( s1, [ & ]( int v ){ sum += v; } );
+
+        s4.reset();
+        s5.reset();
+        assert_true( owner.connected( c ) );
+
+        s1.notify( 1 );
+        assert_true( sum == 1 );
+    }
+}
+
+static void fixed_subjects()
+{
+    int sum = 0;
+
+    // Connect fails when the subject or the owner is full
+    {
+        fixed_subject< 2, int > s;
+        fixed_connection_owner< 3 > owner;
+
+        const auto c1 = owner.connect( s, [ & ]( int v ){ sum += v; } );
+        const auto c2 = owner.connect( s, [ & ]( int v ){ sum += v * 10; } );
+        const auto c3 = owner.connect( s, [ & ]( int v ){ sum += v * 100; } );
+        assert_true( c1 && c2 && !c3 );
+        assert_true( s.observer_count() == 2 );
+        assert_true( owner.connection_count() == 2 );
+        assert_true( !owner.connected( c3 ) );
+
+        s.notify( 1 );
+        assert_true( sum == 11 );
+
+        // Disconnecting makes room for another connection
+        owner.disconnect( c1 );
+        assert_true( !owner.connected( c1 ) );
+        const auto c4 = owner.connect( s, [ & ]( int v ){ sum += v * 100; } );
+        assert_true( c4 );
+        assert_true( !owner.connected( c1 ) );
+
+        sum = 0;
+        s.notify( 1 );
+        assert_true( sum == 110 );
+
+        subject< int > s2;
+        const auto c5 = owner.connect( s2, [ & ]( int v ){ sum += v; } );
+        const auto c6 = owner.connect( s2, [ & ]( int v ){ sum += v; } );
+        assert_true( c5 && !c6 );
+        assert_true( s2.observer_count() == 1 );
+
+        // Blocking
+        assert_true( !owner.set_block_state( c2, true ) );
+        sum = 0;
+        s.notify( 1 );
+        assert_true( sum == 100 );
+        assert_true( owner.set_block_state( c2, false ) );
+    }
+
+    // Observers connected during a notification are notified from the next notification on
+    {
+        fixed_subject< 4, int > s;
+        fixed_connection_owner< 4, 96 > owner;
+        fixed_connection_owner< 4, 96 >::connection c;
+
+        sum = 0;
+        owner.connect( s, [ & ]( int v )
+        {
+            sum += v;
+            if( !c )
+            {
+                c = owner.connect( s, [ & ]( int v ){ sum += v * 10; } );
+            }
+        } );
+
+        s.notify( 1 );
+        assert_true( sum == 1 );
+        assert_true( s.observer_count() == 2 );
+
+        s.notify( 1 );
+        assert_true( sum == 12 );
+
+        // A slot that is disconnected during a notification is reused after the notification
+        const auto c2 = owner.connect( s, [ & ]( int ){ owner.disconnect( c ); } );
+        const auto c3 = owner.connect( s, [ & ]( int ){ sum += 100; } );
+        assert_true( c2 && c3 );
+        assert_true( s.observer_count() == 4 );
+        assert_true( !owner.connect( s, [ & ]( int ){} ) );
+
+        sum = 0;
+        s.notify( 1 );
+        assert_true( sum == 111 );
+        assert_true( s.observer_count() == 3 );
+        assert_true( owner.connect( s, [ & ]( int ){} ) );
+    }
+
+    // The lifetime of the subjects and the owners
+    {
+        auto s     = std::make_unique< fixed_subject< 8, int > >();
+        auto owner = std::make_unique< fixed_connection_owner< 8 > >();
+        for( int i = 0 ; i < 4 ; ++i )
+        {
+            owner->connect( *s, [ & ]( int v ){ sum += v; } );
+        }
+        fixed_connection_owner< 8 > other;
+        const auto c = other.connect( *s, [ & ]( int v ){ sum += v * 10; } );
+
+        owner.reset();
+        assert_true( s->observer_count() == 1 );
+
+        sum = 0;
+        s->notify( 1 );
+        assert_true( sum == 10 );
+
+        s.reset();
+        assert_true( !other.connected( c ) );
+        assert_true( other.connection_count() == 0 );
+    }
+
+    // Handles of a destroyed owner don't match an owner that is constructed at the same address
+    {
+        fixed_subject< 4, int > s;
+        typename std::aligned_storage< sizeof( fixed_connection_owner< 2 > ), alignof( fixed_connection_owner< 2 > ) >::type storage;
+
+        sum = 0;
+        auto first = new( &storage ) fixed_connection_owner< 2 >;
+        const auto c = first->connect( s, [ & ]( int v ){ sum += v; } );
+        first->~fixed_connection_owner();
+
+        auto second = new( &storage ) fixed_connection_owner< 2 >;
+        second->connect( s, [ & ]( int v ){ sum += v * 10; } );
+        assert_true( !second->connected( c ) );
+        assert_true( !second->set_block_state( c, true ) );
+        second->disconnect( c );
+
+        s.notify( 1 );
+        assert_true( sum == 10 );
+        second->~fixed_connection_owner();
+    }
+
+    // An observer can be connected to a fixed subject directly
+    {
+        class counter final : public observer< int >
+        {
+            int &m_sum;
+
+            void notify( int v ) override
+            {
+                m_sum += v;
+            }
+
+            void disconnect() noexcept override
+            {}
+
+        public:
+            explicit counter( int &sum ) noexcept
+                    : m_sum( sum )
+            {}
+        };
+
+        counter o1( sum );
+        counter o2( sum );
+        {
+            fixed_subject< 1, int > s;
+            static_assert( s.capacity() == 1, "the capacity of a fixed subject is its template argument" );
+            assert_true( s.connect( &o1 ) );
+            assert_true( !s.connect( &o2 ) );
+
+            sum = 0;
+            s.notify( 3 );
+            assert_true( sum == 3 );
+
+            s.disconnect( &o1 );
+            assert_true( s.connect( &o2 ) );
+        }
+    }
+}
+
+static void erased_subjects()
+{
+    struct counter
+    {
+        int count = 0;
+
+        void increment( int value )
+        {
+            count += value;
+        }
+    };
+
+    erased_subject< const std::string &, int > s1;
+    erased_subject< int & > s2;
+    erased_subject<> s3;
+    erased_subject< int > s5;
+
+    counter c;
+    std::string received;
+    int sum = 0;
+
+    connection_owner owner;
+    owner.connect( s1, [ & ]( const std::string &str, int i ){ received = str; sum += i; } );
+    owner.connect( s1, [ & ]( std::string str ){ received += str; } );
+    owner.connect( s5, &c, &counter::increment );
+    const auto c2 = owner.connect( s2, []( int &value ){ value *= 2; } );
+    owner.connect( s3, free_function_void );
+    assert_true( s1.observer_count() == 2 );
+
+    const std::string hello( "hello" );
+    s1.notify( hello, 3 );
+    assert_true( received == "hellohello" );
+    assert_true( sum == 3 );
+
+    s5.notify( 4 );
+    assert_true( c.count == 4 );
+
+    // Observers receive references to the values when the signature has reference parameters
+    int value = 21;
+    s2.notify( value );
+    assert_true( value == 42 );
+
+    free_function_reset();
+    s3.notify();
+    assert_true( free_function_void_val == 1 );
+
+    // Blocking and the scoped and fixed connections
+    assert_true( !owner.set_block_state( c2, true ) );
+    s2.notify( value );
+    assert_true( value == 42 );
+    owner.set_block_state( c2, false );
+
+    {
+        auto sc = pg::connect( s2, [ &sum ]( int &v ){ sum += v; } );
+        fixed_connection_owner< 2 > fixed_owner;
+        assert_true( fixed_owner.connect( s3, [ &sum ]{ sum += 100; } ) );
+
+        sum = 0;
+        s2.notify( value );
+        s3.notify();
+        assert_true( sum == 184 );
+        assert_true( s3.observer_count() == 2 );
+    }
+    assert_true( s2.observer_count() == 1 );
+    assert_true( s3.observer_count() == 1 );
+
+    // Connecting and disconnecting during a notification, and destroying a subject before its connection owner
+    {
+        auto s4 = std::make_unique< erased_subject< int > >();
+        connection_owner::connection self;
+        self = owner.connect( *s4, [ & ]( int v )
+        {
+            sum += v;
+            owner.disconnect( self );
+            owner.connect( *s4, [ & ]( int v ){ sum += v * 10; } );
+        } );
+
+        sum = 0;
+        s4->notify( 1 );
+        assert_true( sum == 1 );
+        s4->notify( 1 );
+        assert_true( sum == 11 );
+
+        s4.reset();
+        assert_true( !owner.connected( self ) );
+    }
+}
+
+static void recorded_subjects()
+{
+    struct message
+    {
+        int    id;
+        double value;
+    };
+
+    std::uint64_t time = 0;
+    const auto clock = []{ return std::uint64_t( 1000 ); };
+
+    recorded_subject< int > s1;
+    recorded_blockable_subject< const message &, int > s2;
+
+    int sum = 0;
+    connection_owner owner;
+    owner.connect( s1, [ & ]( int v ){ sum += v; s2.notify( message{ v, 0.5 }, 2 ); } );
+    owner.connect( s2, [ & ]( const message &m, int i ){ sum += m.id * 100 + i; } );
+
+    // Subjects are recorded after they are added to a recorder
+    event_recorder recorder( 1024, clock );
+    s1.notify( 1 );
+    assert_true( recorder.size() == 0 );
+
+    recorder.record( s1, 1 );
+    recorder.record( s2, 2 );
+    assert_true( s1.recording() && s2.recording() );
+
+    sum = 0;
+    s1.notify( 3 );
+    assert_true( sum == 305 );
+    assert_true( recorder.size() == 2 );
+
+    // Notifications while blocked are not recorded
+    s2.block();
+    s2.notify( message{ 9, 0.0 }, 9 );
+    s2.unblock();
+    assert_true( recorder.size() == 2 );
+
+    std::vector< event_recorder::event > events;
+    recorder.for_each( [ & ]( const event_recorder::event &e ){ events.push_back( e ); } );
+    assert_true( events.size() == 2 );
+    assert_true( events[ 0 ].subject == 1 && !events[ 0 ].nested && events[ 0 ].size == sizeof( int ) );
+    assert_true( events[ 1 ].subject == 2 && events[ 1 ].nested && events[ 1 ].size == sizeof( message ) + sizeof( int ) );
+    assert_true( events[ 0 ].timestamp == 1000 );
+
+    message m;
+    std::memcpy( &m, events[ 1 ].data, sizeof( m ) );
+    assert_true( m.id == 3 && m.value == 0.5 );
+
+    // Replay notifies the subjects with the events that are not nested and doesn't record
+    sum = 0;
+    assert_true( recorder.replay() == 1 );
+    assert_true( sum == 305 );
+    assert_true( recorder.size() == 2 );
+
+    // Saved events are loaded in another recorder and replayed on the subjects with the same ids
+    const auto saved = recorder.save();
+    {
+        recorded_subject< int > other;
+        int received = 0;
+        const auto c = pg::connect( other, [ & ]( int v ){ received += v; } );
+
+        event_recorder loaded( 128, nullptr );
+        assert_true( loaded.load( saved.data(), saved.size() ) );
+        assert_true( loaded.size() == 2 );
+        loaded.record( other, 1 );
+        assert_true( loaded.replay() == 1 );
+        assert_true( received == 3 );
+
+        assert_true( !loaded.load( saved.data(), saved.size() - 1 ) );
+        assert_true( loaded.size() == 1 );
+    }
+
+    // The oldest events are overwritten when the buffer is full
+    {
+        event_recorder small( 100, nullptr );
+        small.record( s1, 1 );
+        for( int i = 1 ; i <= 10 ; ++i )
+        {
+            s1.notify( i );
+        }
+        assert_true( small.size() > 0 && small.size() < 10 );
+        assert_true( small.size() + small.overwritten() == 10 );
+
+        int last = 0;
+        small.for_each( [ & ]( const event_recorder::event &e ){ std::memcpy( &last, e.data, sizeof( last ) ); time = e.timestamp; } );
+        assert_true( last == 10 );
+        assert_true( time == 10 );
+    }
+    assert_true( !s1.recording() );
+
+    // Destroying a subject removes it from its recorder
+    {
+        recorded_subject< int > temporary;
+        recorder.record( temporary, 3 );
+        temporary.notify( 1 );
+    }
+    s2.stop();
+    assert_true( !s2.recording() );
+    recorder.clear();
+    assert_true( recorder.replay() == 0 );
+}
+
+static void concurrent_subject_observers()
+{
+    concurrent_subject< int > s;
+
+    int val = 0;
+
+    {
+        connection_owner owner;
+
+        owner.connect( s, [ & ]( int i ){ val += i; } );
+        auto c = connect( s, [ & ]( int i ){ val += i * 10; } );
+
+        s.notify( 1 );
+        assert_true( val == 11 );
+
+        c.reset();
+        s.notify( 1 );
+        assert_true( val == 12 );
+    }
+
+    s.notify( 1 );
+    assert_true( val == 12 );
+
+    // Disconnecting observers from within a notification
+    {
+        scoped_connection c1;
+        scoped_connection c2;
+        scoped_connection c3;
+
+        c1 = connect( s, [ & ]{ ++val; c2.reset(); } );
+        c2 = connect( s, [ & ]{ val += 100; } );
+        c3 = connect( s, [ & ]{ ++val; c3.reset(); } );
+
+        val = 0;
+        s.notify( 1 );
+        assert_true( val == 2 );
+
+        s.notify( 1 );
+        assert_true( val == 3 );
+    }
+
+    // Notify from multiple threads while connecting and disconnecting from another thread
+    {
+        std::atomic< int >  count{ 0 };
+        std::atomic< bool > done{ false };
+
+        auto stable = connect( s, [ & ]( int i ){ count += i; } );
+
+        const auto publisher = [ & ]
+        {
+            for( int i = 0 ; i < 10000 ; ++i )
+            {
+                s.notify( 1 );
+            }
+        };
+
+        std::thread subscriber( [ & ]
+        {
+            while( !done )
+            {
+                std::atomic< int > local{ 0 };
+                auto c             = connect( s, [ &local ]( int i ){ local += i; } );
+                std::this_thread::yield();
+            }
+        } );
+
+        std::thread publisher_1( publisher );
+        std::thread publisher_2( publisher );
+        publisher_1.join();
+        publisher_2.join();
+        done = true;
+        subscriber.join();
+
+        assert_true( count == 20000 );
+    }
+
+    // Observers on two threads that disconnect themselves while notified by different subjects don't wait for each other
+    {
+        std::atomic< int > inside{ 0 };
+
+        const auto disconnect_during_notify = [ & ]
+        {
+            concurrent_subject< int > local;
+            int received = 0;
+
+            scoped_connection c;
+            c = connect( local, [ & ]( int v )
+            {
+                // Both threads are in a notification when they disconnect
+                ++inside;
+                while( inside < 2 )
+                {
+                    std::this_thread::yield();
+                }
+                received += v;
+                c.reset();
+            } );
+            local.notify( 1 );
+            local.notify( 1 );
+            return received;
+        };
+
+        int received_1 = 0;
+        int received_2 = 0;
+        std::thread thread_1( [ & ]{ received_1 = disconnect_during_notify(); } );
+        std::thread thread_2( [ & ]{ received_2 = disconnect_during_notify(); } );
+        thread_1.join();
+        thread_2.join();
+
+        assert_true( received_1 == 1 );
+        assert_true( received_2 == 1 );
+    }
+
+    // Observers are disconnected when the subject is destroyed
+    {
+        connection_owner owner;
+        scoped_connection c;
+
+        {
+            concurrent_subject<> s_void;
+            owner.connect( s_void, [ & ]{ ++val; } );
+            c = connect( s_void, [ & ]{ ++val; } );
+        }
+    }
+}
+
+static void queued_subject_observers()
+{
+    std::vector< int > received;
+
+    // Notifications are delivered when the queue is dispatched
+    {
+        queued_subject< int > s( 4 );
+        connection_owner owner;
+        owner.connect( s, [ & ]( int i ){ received.push_back( i ); } );
+
+        s.notify( 1 );
+        s.notify( 2 );
+        assert_true( received.empty() );
+        assert_true( s.size() == 2 );
+
+        assert_true( s.dispatch() == 2 );
+        assert_true( received == std::vector< int >( { 1, 2 } ) );
+        assert_true( s.dispatch() == 0 );
+    }
+
+    // Drop oldest
+    {
+        received.clear();
+
+        queued_subject< int > s( 2, overflow_policy::drop_oldest );
+        auto c = connect( s, [ & ]( int i ){ received.push_back( i ); } );
+
+        s.notify( 1 );
+        s.notify( 2 );
+        s.notify( 3 );
+        s.dispatch();
+        assert_true( received == std::vector< int >( { 2, 3 } ) );
+    }
+
+    // Coalesce
+    {
+        received.clear();
+
+        queued_subject< int > s( 2, overflow_policy::coalesce );
+        auto c = connect( s, [ & ]( int i ){ received.push_back( i ); } );
+
+        s.notify( 1 );
+        s.notify( 2 );
+        s.notify( 3 );
+        s.notify( 4 );
+        s.dispatch();
+        assert_true( received == std::vector< int >( { 1, 4 } ) );
+    }
+
+    // Values are stored by copy
+    {
+        std::string str;
+
+        queued_subject< const std::string & > s( 1 );
+        auto c = connect( s, [ & ]( const std::string &v ){ str = v; } );
+
+        {
+            const std::string temp = "foo";
+            s.notify( temp );
+        }
+        s.dispatch();
+        assert_true( str == "foo" );
+    }
+
+    // Executor
+    {
+        std::vector< std::function< void() > > tasks;
+
+        queued_subject< int > s( 8, overflow_policy::block, [ & ]( std::function< void() > task ){ tasks.push_back( std::move( task ) ); } );
+        int sum = 0;
+        auto c  = connect( s, [ & ]( int i ){ sum += i; } );
+
+        s.notify( 1 );
+        s.notify( 2 );
+        assert_true( tasks.size() == 1 );
+
+        tasks.front()();
+        assert_true( sum == 3 );
+
+        s.notify( 3 );
+        assert_true( tasks.size() == 2 );
+        tasks.back()();
+        assert_true( sum == 6 );
+    }
+
+    // Dispatch by an observer of the dispatching thread
+    {
+        queued_subject< int > s( 4 );
+        std::size_t nested = 1;
+        auto c             = connect( s, [ & ]( int ){ nested = s.dispatch(); } );
+
+        s.notify( 1 );
+        s.notify( 2 );
+        assert_true( s.dispatch() == 2 );
+        assert_true( nested == 0 );
+    }
+
+    // Tasks of the executor that run at the same time on different threads
+    {
+        std::mutex                 threads_mutex;
+        std::vector< std::thread > threads;
+        std::atomic< int >         active( 0 );
+        std::atomic< int >         last( 0 );
+        bool                       in_order = true;
+        bool                       overlap  = false;
+
+        {
+            // The owner outlives the subject, the destructor of the subject waits for the task that dispatches
+            connection_owner      owner;
+            queued_subject< int > s( 4, overflow_policy::block, [ & ]( std::function< void() > task )
+            {
+                std::lock_guard< std::mutex > lock( threads_mutex );
+                threads.emplace_back( std::move( task ) );
+            } );
+            owner.connect( s, [ & ]( int i )
+            {
+                overlap  = overlap || active.fetch_add( 1 ) != 0;
+                in_order = in_order && last.load() + 1 == i;
+                last.store( i );
+                std::this_thread::yield();
+                active.fetch_sub( 1 );
+            } );
+
+            for( int i = 1 ; i <= 1000 ; ++i )
+            {
+                s.notify( i );
+            }
+            while( last.load() != 1000 )
+            {
+                std::this_thread::yield();
+            }
+        }
+
+        // A task that was rescheduled before the destruction can still add a thread
+        for( ;; )
+        {
+            std::vector< std::thread > finished;
+            {
+                std::lock_guard< std::mutex > lock( threads_mutex );
+                finished.swap( threads );
+            }
+            if( finished.empty() )
+            {
+                break;
+            }
+            for( auto &t : finished )
+            {
+                t.join();
+            }
+        }
+        assert_true( in_order );
+        assert_true( !overlap );
+    }
+
+    // A worker thread that ends because an observer throws doesn't block the destruction of the subject
+    {
+        bool thrown = false;
+        {
+            queued_subject< int > s( 4 );
+            auto c = connect( s, []( int i ){ if( i == 42 ) throw i; } );
+
+            std::thread worker( [ & ]
+            {
+                try
+                {
+                    s.run();
+                }
+                catch( int )
+                {
+                    thrown = true;
+                }
+            } );
+            s.notify( 42 );
+            worker.join();
+
+            s.notify( 1 );
+            assert_true( s.dispatch() == 1 );
+        }
+        assert_true( thrown );
+    }
+
+    // Tasks of the executor that run after the destruction of the subject
+    {
+        std::vector< std::function< void() > > tasks;
+        int sum = 0;
+
+        {
+            queued_subject< int > s( 8, overflow_policy::block, [ & ]( std::function< void() > task ){ tasks.push_back( std::move( task ) ); } );
+            auto c = connect( s, [ & ]( int i ){ sum += i; } );
+
+            s.notify( 1 );
+        }
+
+        assert_true( tasks.size() == 1 );
+        tasks.front()();
+        assert_true( sum == 0 );
+    }
+
+    // Worker thread with a blocking producer
+    {
+        queued_subject< int > s( 4 );
+        int sum = 0;
+        auto c  = connect( s, [ & ]( int i ){ sum += i; } );
+
+        std::thread worker( [ & ]{ s.run(); } );
+        for( int i = 1 ; i <= 1000 ; ++i )
+        {
+            s.notify( i );
+        }
+        while( s.size() )
+        {
+            std::this_thread::yield();
+        }
+        s.stop();
+        worker.join();
+        s.dispatch();
+
+        assert_true( sum == 500500 );
+        assert_true( !s.notify( 1 ) );
+    }
+}
+
+static void parallel_notify()
+{
+    subject< int > s;
+    connection_owner owner;
+
+    const std::size_t              count = 2000;
+    std::vector< int >             received( count, 0 );
+    std::vector< std::thread::id > ids( count );
+
+    for( std::size_t i = 0 ; i < count ; ++i )
+    {
+        owner.connect( s, [ &, i ]( int v ){ received[ i ] += v; ids[ i ] = std::this_thread::get_id(); } );
+    }
+
+    // Below the threshold the observers are notified by the calling thread
+    parallel_threads policy;
+    policy.threshold = count + 1;
+
+    s.notify_parallel( policy, 1 );
+    assert_true( std::all_of( received.cbegin(), received.cend(), []( int v ){ return v == 1; } ) );
+    assert_true( std::all_of( ids.cbegin(), ids.cend(), []( std::thread::id id ){ return id == std::this_thread::get_id(); } ) );
+
+    // All observers are notified once before notify_parallel returns
+    policy.threshold  = 100;
+    policy.chunk_size = 100;
+    policy.threads    = 4;
+
+    s.notify_parallel( policy, 2 );
+    assert_true( std::all_of( received.cbegin(), received.cend(), []( int v ){ return v == 3; } ) );
+    assert_true( ids.front() == std::this_thread::get_id() );
+    assert_true( ids.back() != std::this_thread::get_id() );
+
+    // Disconnected observers are skipped
+    scoped_connection c = connect( s, [ & ]( int ){ received.front() += 100; } );
+    c.reset();
+    s.notify_parallel( policy, 1 );
+    assert_true( received.front() == 4 && received.back() == 4 );
+}
+
+static void batch_notify()
+{
+    struct sum_observer final : batch_observer< int, const std::string & >
+    {
+        int sum     = 0;
+        int batches = 0;
+
+        void disconnect() noexcept override {}
+
+        void notify_batch( const event_type *events, std::size_t count ) override
+        {
+            ++batches;
+            for( std::size_t i = 0 ; i < count ; ++i )
+            {
+                sum += std::get< 0 >( events[ i ] );
+            }
+        }
+    };
+
+    using subject_type = subject< int, const std::string & >;
+    using event_type   = subject_type::event_type;
+
+    subject_type s;
+    sum_observer batch;
+    std::string str;
+    int per_event = 0;
+
+    s.connect( &batch );
+    auto c = connect( s, [ & ]( int, const std::string &v ){ ++per_event; str += v; } );
+
+    const std::vector< event_type > events = { event_type( 1, "a" ), event_type( 2, "b" ), event_type( 3, "c" ) };
+    s.notify_batch( events );
+    assert_true( batch.sum == 6 );
+    assert_true( batch.batches == 1 );
+    assert_true( per_event == 3 );
+    assert_true( str == "abc" );
+
+    // A single notification is a batch of one for batch observers
+    s.notify( 4, "d" );
+    assert_true( batch.sum == 10 );
+    assert_true( batch.batches == 2 );
+    assert_true( str == "abcd" );
+
+    // Observers that disconnect during the batch don't receive the remaining notifications
+    c = connect( s, [ & ]( int, const std::string & ){ ++per_event; c.reset(); } );
+    per_event = 0;
+    s.notify_batch( events.data(), events.size() );
+    assert_true( per_event == 1 );
+    assert_true( batch.batches == 3 );
+
+    s.disconnect( &batch );
+}
+
+static void static_subject_observers()
+{
+    int sum     = 0;
+    int calls   = 0;
+    int functor = 0;
+
+    auto s = make_static_subject( [ & ]( int i ){ sum += i; },
+                                  [ & ]{ ++calls; },
+                                  functor_int( functor ),
+                                  free_function_int );
+
+    s.notify( 10 );
+    assert_true( sum == 10 );
+    assert_true( calls == 1 );
+    assert_true( functor == 10 );
+    assert_true( free_function_int_val == 10 );
+
+    s.notify( 5, "ignored" );
+    assert_true( sum == 15 );
+    assert_true( calls == 2 );
+    assert_true( functor == 5 );
+
+    // Notifying a subject without observers compiles to nothing
+    static_subject<> empty;
+    empty.notify( 1 );
+
+    // Values are passed as lvalues so that each callable receives the same value
+    std::string str;
+    auto s_string = make_static_subject( [ & ]( std::string v ){ str += v; }, [ & ]( std::string v ){ str += v; } );
+    s_string.notify( std::string( "foo" ) );
+    assert_true( str == "foofoo" );
+}
+
+static void priority_subject_observers()
+{
+    priority_subject< int > s;
+    std::string order;
+
+    connection_owner owner;
+    owner.connect( s, [ & ]( int ){ order += "a"; } );
+    owner.connect( s.with_priority( 10 ), [ & ]( int ){ order += "b"; } );
+    auto c = connect( s.with_priority( 5 ), [ & ]( int i, dispatch_control &control )
+    {
+        order += "c";
+        if( i == 1 )
+        {
+            control.stop();
+        }
+    } );
+    owner.connect( s.with_priority( 10 ), [ & ]( int ){ order += "d"; } );
+    owner.connect( s.with_priority( -1 ), [ & ]{ order += "e"; } );
+
+    assert_true( !s.notify( 0 ) );
+    assert_true( order == "bdcae" );
+
+    order.clear();
+    assert_true( s.notify( 1 ) );
+    assert_true( order == "bdc" );
+
+    c.reset();
+    order.clear();
+    assert_true( !s.notify( 1 ) );
+    assert_true( order == "bdae" );
+
+    // Observers connected while notifying are inserted at their priority when the notification returns
+    priority_subject<> r;
+    std::string received;
+
+    connection_owner r_owner;
+    r_owner.connect( r, [ & ]
+    {
+        received += "1";
+        if( received == "01" )
+        {
+            r_owner.connect( r.with_priority( 1 ), [ & ]{ received += "2"; } );
+            r_owner.connect( r.with_priority( -1 ), [ & ]{ received += "3"; } );
+        }
+    } );
+    auto c_stop = connect( r.with_priority( 2 ), [ & ]( dispatch_control &control )
+    {
+        received += "0";
+        if( received.size() > 4 )
+        {
+            control.stop();
+        }
+    } );
+
+    r.notify();
+    assert_true( received == "01" );
+
+    r.notify();
+    assert_true( received == "010213" );
+
+    r.notify();
+    assert_true( received == "0102130" );
+
+    c_stop.reset();
+    received.clear();
+    r.notify();
+    assert_true( received == "213" );
+}
+
+static void collecting_subject_observers()
+{
+    struct plugin
+    {
+        int m_weight;
+
+        int weight( int i ) const
+        {
+            return m_weight * i;
+        }
+    };
+
+    const plugin p{ 10 };
+
+    collecting_subject< sum< int >, int > s_sum;
+    connection_owner owner;
+    owner.connect( s_sum, []( int i ){ return i; } );
+    owner.connect( s_sum, []( int i ){ return i * 2; } );
+    owner.connect( s_sum, &p, &plugin::weight );
+    owner.connect( s_sum, []( int ){} );
+    owner.connect( s_sum, []( int i, result_sink< sum< int > > &sink ){ sink.collect( i * 100 ); } );
+    assert_true( s_sum.notify( 1 ) == 113 );
+    assert_true( s_sum.notify( 2 ) == 226 );
+
+    collecting_subject< minimum< int >, int > s_min;
+    collecting_subject< maximum< int >, int > s_max;
+    collecting_subject< last< std::string > > s_last;
+    for( int i : { 3, -2, 7 } )
+    {
+        owner.connect( s_min, [ i ]( int v ){ return i * v; } );
+        owner.connect( s_max, [ i ]( int v ){ return i * v; } );
+        owner.connect( s_last, [ i ]{ return std::to_string( i ); } );
+    }
+    assert_true( s_min.notify( 1 ) == -2 );
+    assert_true( s_max.notify( 1 ) == 7 );
+    assert_true( s_min.notify( -1 ) == -7 );
+    assert_true( s_last.notify() == "7" );
+
+    minimum< int > empty;
+    collecting_subject< minimum< int >, int >().collect( empty, 1 );
+    assert_true( empty.empty() );
+
+    collecting_subject< any_of, char > s_any;
+    int calls = 0;
+    owner.connect( s_any, [ & ]( char c ){ ++calls; return c == 'a'; } );
+    owner.connect( s_any, [ & ]( char c ){ ++calls; return c == 'b'; } );
+    owner.connect( s_any, [ & ]( char c ){ ++calls; return c == 'c'; } );
+    assert_true( s_any.notify( 'b' ) );
+    assert_true( calls == 2 );
+    assert_true( !s_any.notify( 'd' ) );
+    assert_true( calls == 5 );
+
+    using join = reducer< std::string, std::string ( * )( std::string, const std::string & ) >;
+    collecting_subject< join, const std::string & > s_join;
+    owner.connect( s_join, []( const std::string &str ){ return str + "1"; } );
+    auto c = connect( s_join, []( const std::string &str ){ return str + "2"; } );
+
+    auto joined = make_reducer( std::string( ">" ), []( std::string a, const std::string &b ){ return a + b; } );
+    join combiner( ">", []( std::string a, const std::string &b ){ return a + b; } );
+    s_join.collect( combiner, "x" );
+    assert_true( combiner.result() == ">x1x2" );
+    joined( "y" );
+    assert_true( joined.result() == ">y" );
+}
+
+static void channel_observers()
+{
+    {
+        channel< const std::string &, int > c( 3 );
+        assert_true( c.capacity() == 4 );
+
+        subject< const std::string &, int > s;
+        connection_owner owner;
+        owner.connect( s, c.sender() );
+
+        for( int i = 0 ; i < 6 ; ++i )
+        {
+            s.notify( std::to_string( i ), i );
+        }
+        assert_true( c.dropped() == 2 );
+
+        std::string received;
+        assert_true( c.drain( [ & ]( std::string str, int ){ received += str; } ) == 4 );
+        assert_true( received == "0123" );
+        assert_true( c.drain( [ & ]{ received += "x"; } ) == 0 );
+
+        // Notifications that are left in the channel are destroyed by the channel
+        s.notify( "left", 0 );
+    }
+
+    // A push of which copying a value throws doesn't block the notifications that are pushed after it
+    {
+        struct throwing_copy
+        {
+            bool throws;
+            int  value;
+
+            throwing_copy( bool t, int v ) noexcept : throws( t ), value( v ) {}
+            throwing_copy( const throwing_copy &other ) : throws( other.throws ), value( other.value )
+            {
+                if( throws )
+                {
+                    throw std::runtime_error( "copy" );
+                }
+            }
+        };
+
+        channel< const throwing_copy & > c( 4 );
+        assert_true( c.push( throwing_copy( false, 1 ) ) );
+
+        bool caught = false;
+        try
+        {
+            c.push( throwing_copy( true, 2 ) );
+        }
+        catch( const std::runtime_error & )
+        {
+            caught = true;
+        }
+        assert_true( caught );
+        assert_true( c.push( throwing_copy( false, 3 ) ) );
+
+        int sum = 0;
+        assert_true( c.drain( [ & ]( throwing_copy t ){ sum += t.value; } ) == 2 );
+        assert_true( sum == 4 );
+
+        // The cell of the failed push is free again
+        for( int i = 0 ; i < 4 ; ++i )
+        {
+            assert_true( c.push( throwing_copy( false, 1 ) ) );
+        }
+        assert_true( !c.push( throwing_copy( false, 1 ) ) );
+        assert_true( c.drain( []{} ) == 4 );
+    }
+
+    const int producers = 4;
+    const int count     = 10000;
+
+    channel< int > c( 256 );
+    subject< int > s[ producers ];
+    std::vector< scoped_connection > connections;
+    for( auto &p : s )
+    {
+        connections.push_back( connect( p, c.sender() ) );
+    }
+
+    std::atomic< int > done{ 0 };
+    std::vector< std::thread > threads;
+    for( int p = 0 ; p < producers ; ++p )
+    {
+        threads.emplace_back( [ &, p ]
+        {
+            for( int i = 1 ; i <= count ; ++i )
+            {
+                while( !c.push( i ) )
+                {
+                    std::this_thread::yield();
+                }
+                s[ p ].notify( 0 );
+            }
+            ++done;
+        } );
+    }
+
+    long long   sum   = 0;
+    std::size_t zeros = 0;
+    for( ;; )
+    {
+        // Test whether the producers are done before draining so that no notification is left behind
+        const bool        finished = done == producers;
+        const std::size_t drained  = c.drain( [ & ]( int i ){ sum += i; zeros += i == 0; } );
+        if( finished && drained == 0 )
+        {
+            break;
+        }
+    }
+
+    for( auto &t : threads )
+    {
+        t.join();
+    }
+
+    const long long expected = static_cast< long long >( producers ) * count * ( count + 1 ) / 2;
+    assert_true( sum == expected );
+    assert_true( zeros <= static_cast< std::size_t >( producers ) * count );
+    assert_true( zeros + c.dropped() >= static_cast< std::size_t >( producers ) * count ); // Includes the retried pushes
+}
+
+static void operator_pipelines()
+{
+    subject< int >                 source;
+    subject< int >                 doubled;
+    subject< const std::string & > text;
+
+    std::vector< int > received;
+    std::string        joined;
+    int                calls = 0;
+
+    auto c_source = connect( source, pipe< int >( map( [ & ]( int i ){ ++calls; return i * 2; } ),
+                                                  filter( []( int i ){ return i > 3; } ),
+                                                  distinct_until_changed< int >(),
+                                                  into( doubled ) ) );
+
+    // The operators are skipped while the subject at the end of the pipeline has no observers
+    source.notify( 5 );
+    assert_true( calls == 0 );
+
+    auto c_doubled = connect( doubled, [ & ]( int i ){ received.push_back( i ); } );
+    for( int i : { 1, 2, 3, 3, 3, 4, 2, 5 } )
+    {
+        source.notify( i );
+    }
+    assert_true( calls == 8 );
+    assert_true( received == std::vector< int >( { 4, 6, 8, 4, 10 } ) );
+
+    // A pipeline may end in a callable and the operators may ignore values
+    subject< int, const char * > pairs;
+    auto c_pairs = connect( pairs, pipe< int, const char * >( filter( []( int i ){ return i % 2 == 0; } ),
+                                                              map( []( int, const char *str ){ return std::string( str ); } ),
+                                                              sample( 2 ),
+                                                              [ & ]( const std::string &str ){ joined += str; } ) );
+    pairs.notify( 0, "a" );
+    pairs.notify( 1, "b" );
+    pairs.notify( 2, "c" );
+    pairs.notify( 4, "d" );
+    pairs.notify( 6, "e" );
+    assert_true( joined == "ce" );
+
+    int throttled = 0;
+    auto c_throttle = connect( source, pipe< int >( throttle( std::chrono::hours( 1 ) ), [ & ]{ ++throttled; } ) );
+    source.notify( 1 );
+    source.notify( 2 );
+    assert_true( throttled == 1 );
+
+    // A sink without operators
+    connection_owner owner;
+    owner.connect( text, pipe< const std::string & >( [ & ]( const std::string &str ){ joined = str; } ) );
+    text.notify( "sink" );
+    assert_true( joined == "sink" );
+}
+
+#if defined( __cpp_impl_coroutine )
+// A coroutine that starts right away and of which the frame can be destroyed while it is suspended.
+struct awaiting_task
+{
+    struct promise_type
+    {
+        awaiting_task get_return_object() noexcept
+        {
+            return awaiting_task( std::coroutine_handle< promise_type >::from_promise( *this ) );
+        }
+
+        std::suspend_never initial_suspend() noexcept
+        {
+            return {};
+        }
+
+        std::suspend_always final_suspend() noexcept
+        {
+            return {};
+        }
+
+        void return_void() noexcept
+        {}
+
+        void unhandled_exception() noexcept
+        {
+            std::terminate();
+        }
+    };
+
+    std::coroutine_handle< promise_type > handle;
+
+    explicit awaiting_task( std::coroutine_handle< promise_type > h ) noexcept
+            : handle( h )
+    {}
+
+    awaiting_task( awaiting_task &&other ) noexcept
+            : handle( std::exchange( other.handle, nullptr ) )
+    {}
+
+    ~awaiting_task() noexcept
+    {
+        if( handle )
+        {
+            handle.destroy();
+        }
+    }
+
+    bool done() const noexcept
+    {
+        return handle.done();
+    }
+};
+
+static awaiting_task sum_values( subject< int > &s, int &sum )
+{
+    while( const auto value = co_await pg::next( s ) )
+    {
+        sum += *value;
+    }
+}
+
+static awaiting_task join_values( blockable_subject< const std::string &, int > &s, std::string &text )
+{
+    for( int i = 0 ; i < 2 ; ++i )
+    {
+        const auto values = co_await pg::next( s );
+        text += std::get< 0 >( *values ) + std::to_string( std::get< 1 >( *values ) );
+    }
+}
+
+static awaiting_task count_notifications( subject<> &s, int &count )
+{
+    // The result is bound to a variable since GCC 12 miscompiles a co_await that is only tested in a while condition
+    while( const auto notified = co_await pg::next( s ) )
+    {
+        ++count;
+    }
+}
+
+// Tests whether pg::next accepts a subject type
+template< typename S, typename = void >
+struct can_await_next : std::false_type {};
+
+template< typename S >
+struct can_await_next< S, decltype( void( pg::next( std::declval< S & >() ) ) ) > : std::true_type {};
+
+static_assert( can_await_next< subject< int > >::value, "pg::next accepts a subject" );
+static_assert( !can_await_next< erased_subject< int > >::value, "pg::next rejects an erased subject" );
+
+static awaiting_task first_priority_value( priority_subject< int > &s, int &value )
+{
+    const auto values = co_await pg::next( s );
+    value             = std::get< 0 >( *values );
+}
+
+static awaiting_task sum_fixed_values( fixed_subject< 2, int > &s, int &sum )
+{
+    while( const auto value = co_await pg::next( s ) )
+    {
+        sum += *value;
+    }
+}
+
+static awaiting_task count_concurrent_notifications( concurrent_subject< int > &s, int &count )
+{
+    while( const auto value = co_await pg::next( s ) )
+    {
+        count += *value;
+    }
+}
+#endif
+
+static void awaitable_subjects()
+{
+#if defined( __cpp_impl_coroutine )
+    {
+        int sum = 0;
+        auto s  = std::make_unique< subject< int > >();
+
+        auto task = sum_values( *s, sum );
+        assert_true( s->observer_count() == 1 );
+
+        s->notify( 1 );
+        s->notify( 2 );
+        assert_true( sum == 3 );
+        assert_true( s->observer_count() == 1 );
+
+        // The coroutine waits again during the notification, it is connected for the next notification
+        int other = 0;
+        auto c    = connect( *s, [ & ]( int i ){ other += i; } );
+        s->notify( 3 );
+        assert_true( sum == 6 );
+        assert_true( other == 3 );
+        c.reset();
+
+        // Destroying the subject ends the wait without a value
+        assert_true( !task.done() );
+        s.reset();
+        assert_true( task.done() );
+        assert_true( sum == 6 );
+    }
+
+    {
+        std::string text;
+        blockable_subject< const std::string &, int > s;
+
+        auto task = join_values( s, text );
+        s.block();
+        s.notify( "blocked", 0 );
+        assert_true( text.empty() );
+        s.unblock();
+
+        s.notify( "a", 1 );
+        s.notify( "b", 2 );
+        assert_true( text == "a1b2" );
+        assert_true( task.done() );
+        assert_true( s.observer_count() == 0 );
+    }
+
+    // Destroying a suspended coroutine disconnects it from the subject
+    {
+        int count = 0;
+        subject<> s;
+        {
+            auto task = count_notifications( s, count );
+            s.notify();
+            assert_true( count == 1 );
+            assert_true( s.observer_count() == 1 );
+        }
+        assert_true( s.observer_count() == 0 );
+        s.notify();
+        assert_true( count == 1 );
+    }
+
+    // The values are deduced from the connect function of the subject
+    {
+        int value = 0;
+        priority_subject< int > s;
+
+        auto task = first_priority_value( s, value );
+        assert_true( s.notify( 42 ) == false );
+        assert_true( value == 42 );
+        assert_true( task.done() );
+    }
+
+    {
+        int sum = 0;
+        fixed_subject< 2, int > s;
+
+        auto task = sum_fixed_values( s, sum );
+        s.notify( 1 );
+        assert_true( sum == 1 );
+        assert_true( s.observer_count() == 1 );
+
+        // The subject is full during the notification, the wait ends without a value
+        s.notify( 2 );
+        assert_true( sum == 3 );
+        assert_true( s.observer_count() == 0 );
+        assert_true( task.done() );
+    }
+
+    // Notifications of a concurrent subject on two threads resume the coroutine once for each wait
+    {
+        int count = 0;
+        auto s    = std::make_unique< concurrent_subject< int > >();
+        auto task = count_concurrent_notifications( *s, count );
+
+        const auto publisher = [ & ]
+        {
+            for( int i = 0 ; i < 10000 ; ++i )
+            {
+                s->notify( 1 );
+            }
+        };
+
+        std::thread publisher_1( publisher );
+        std::thread publisher_2( publisher );
+        publisher_1.join();
+        publisher_2.join();
+
+        assert_true( count >= 1 && count <= 20000 );
+        assert_true( !task.done() );
+        s.reset();
+        assert_true( task.done() );
+    }
+#endif
+}
+
+struct key_pressed : topic< char > {};
+struct text_changed : topic< const std::string &, int > {};
+
+static void event_bus_topics()
+{
+    event_bus bus;
+
+    // Publishing on topics without observers does nothing
+    bus.publish< key_pressed >( 'a' );
+    bus.publish( topic_handle< int >(), 1 );
+
+    std::string keys;
+    std::string text;
+    int         total = 0;
+
+    connection_owner owner;
+    owner.connect( bus.subject< key_pressed >(), [ & ]( char c ){ keys += c; } );
+    owner.connect( bus.subject< text_changed >(), [ & ]( const std::string &str, int pos ){ text = str; total += pos; } );
+
+    bus.publish< key_pressed >( 'b' );
+    bus.publish< text_changed >( "hello", 5 );
+    assert_true( keys == "b" );
+    assert_true( text == "hello" );
+    assert_true( total == 5 );
+
+    const auto volume = bus.intern< int >( "audio/volume" );
+    const auto muted  = bus.intern<>( "audio/muted" );
+    assert_true( &bus.subject( bus.intern< int >( "audio/volume" ) ) == &bus.subject( volume ) );
+
+    bool caught = false;
+    try
+    {
+        bus.intern< float >( "audio/volume" );
+    }
+    catch( const std::invalid_argument & )
+    {
+        caught = true;
+    }
+    assert_true( caught );
+
+    auto c_volume = connect( bus.subject( volume ), [ & ]( int v ){ total += v; } );
+    auto c_muted  = connect( bus.subject( muted ), [ & ]{ total = 0; } );
+
+    bus.publish( volume, 10 );
+    assert_true( total == 15 );
+    bus.publish( muted );
+    assert_true( total == 0 );
+
+    // Other buses have their own subjects
+    event_bus other;
+    other.publish< key_pressed >( 'c' );
+    assert_true( keys == "b" );
+
+    // Handles of another bus with the same index but other value types, and default constructed handles, are rejected
+    const auto other_flag   = other.intern< bool >( "flag" );
+    const auto other_volume = other.intern< int >( "audio/volume" );
+    auto c_other            = connect( other.subject( other_flag ), [ & ]( bool ){ total += 100; } );
+    total                   = 0;
+
+    bus.publish( other_flag, true );
+    bus.publish( other_volume, 1 );
+    bus.publish( topic_handle< int >(), 1 );
+    assert_true( total == 0 );
+
+    const auto throws = [ & ]( const auto &subject_of )
+    {
+        bool thrown = false;
+        try
+        {
+            subject_of();
+        }
+        catch( const std::invalid_argument & )
+        {
+            thrown = true;
+        }
+        return thrown;
+    };
+    assert_true( throws( [ & ]{ bus.subject( other_flag ); } ) );
+    assert_true( throws( [ & ]{ bus.subject( other_volume ); } ) );
+    assert_true( throws( [ & ]{ bus.subject( topic_handle< int >() ); } ) );
+
+    other.publish( other_flag, true );
+    assert_true( total == 100 );
+}
+
+static void instrumented_subject_observers()
+{
+    subject_statistics statistics;
+
+    // The thresholds are 0 or the maximum duration, or the durations are reported directly, so that the results don't depend on timing
+    const void *             slow       = nullptr;
+    int                      slow_count = 0;
+    std::chrono::nanoseconds slow_duration( 0 );
+    const auto               on_slow    = [ & ]( const void * o, std::chrono::nanoseconds d )
+    {
+        slow          = o;
+        slow_duration = d;
+        ++slow_count;
+    };
+    statistics.set_slow_observer_handler( std::chrono::nanoseconds::max(), on_slow );
+
+    instrumented_subject< subject_statistics, int > s( statistics );
+    instrumented_blockable_subject< subject_statistics, int > b( statistics );
+
+    int sum = 0;
+
+    connection_owner owner;
+    owner.connect( s, [ & ]( int i ){ sum += i; } );
+    owner.connect( s, [ & ]( int i ){ sum += i; } );
+    auto c_other = connect( s, []( int ){} );
+    owner.connect( b, [ & ]( int i ){ sum += i; } );
+
+    s.notify( 1 );
+    s.notify( 2 );
+    assert_true( sum == 6 );
+    assert_true( statistics.notifications() == 2 );
+    assert_true( statistics.observer_calls() == 6 );
+    assert_true( statistics.max_observers() == 3 );
+    assert_true( slow_count == 0 );
+
+    std::uint64_t histogram = 0;
+    for( std::size_t i = 0 ; i < subject_statistics::buckets ; ++i )
+    {
+        histogram += statistics.histogram( i );
+    }
+    assert_true( histogram == 6 );
+
+    // Each observer takes at least 0 ns
+    statistics.set_slow_observer_handler( std::chrono::nanoseconds( 0 ), on_slow );
+    s.notify( 10 );
+    assert_true( slow_count == 3 );
+    assert_true( slow != nullptr );
+    statistics.set_slow_observer_handler( std::chrono::nanoseconds::max(), on_slow );
+
+    {
+        subject_blocker< instrumented_blockable_subject< subject_statistics, int > > blocker( b );
+        b.notify( 1 );
+    }
+    b.notify( 1 );
+    assert_true( sum == 27 );
+    assert_true( statistics.notifications() == 4 );
+    assert_true( statistics.observer_calls() == 10 );
+
+    statistics.reset();
+    assert_true( statistics.notifications() == 0 );
+    assert_true( statistics.observer_calls() == 0 );
+    assert_true( statistics.max_observers() == 0 );
+    assert_true( statistics.histogram( 0 ) == 0 );
+
+    // Durations reported by a subject are compared with the threshold and counted in the bucket [2^i, 2^(i+1)) ns
+    const int observer = 0;
+    slow_count         = 0;
+    statistics.set_slow_observer_handler( std::chrono::milliseconds( 1 ), on_slow );
+    statistics.on_observer( &observer, std::chrono::microseconds( 999 ) );
+    assert_true( slow_count == 0 );
+    statistics.on_observer( &observer, std::chrono::milliseconds( 2 ) );
+    assert_true( slow_count == 1 );
+    assert_true( slow == &observer );
+    assert_true( slow_duration == std::chrono::milliseconds( 2 ) );
+    assert_true( statistics.observer_calls() == 2 );
+    assert_true( statistics.histogram( 19 ) == 1 ); // 999000 ns
+    assert_true( statistics.histogram( 20 ) == 1 ); // 2000000 ns
+    statistics.on_observer( &observer, std::chrono::nanoseconds( 0 ) );
+    assert_true( statistics.histogram( 0 ) == 1 );
+}
+
 static void block_subject()
 {
     connection_owner    owner;
@@ -615,6 +2811,233 @@ static void block_subject()
     assert_true( val == 4 );
 }
 
+static void coalescing_subject_observers()
+{
+    coalescing_subject< const std::string & > s;
+    std::string received;
+    int         count = 0;
+
+    auto c = connect( s, [ & ]( const std::string &str ){ received += str; ++count; } );
+
+    s.notify( "a" );
+    assert_true( received == "a" );
+    assert_true( count == 1 );
+
+    {
+        subject_blocker< coalescing_subject< const std::string & > > outer( s );
+
+        s.notify( "b" );
+        s.notify( "c" );
+
+        {
+            subject_blocker< coalescing_subject< const std::string & > > inner( s );
+
+            s.notify( "d" );
+        }
+
+        assert_true( count == 1 );
+        assert_true( s.pending() );
+    }
+
+    assert_true( received == "ad" );
+    assert_true( count == 2 );
+    assert_true( !s.pending() );
+
+    // Nothing is notified when there was no notification while blocked
+    {
+        subject_blocker< coalescing_subject< const std::string & > > blocker( s );
+    }
+    assert_true( count == 2 );
+
+    s.block();
+    s.notify( "e" );
+    s.discard();
+    s.unblock();
+    assert_true( count == 2 );
+
+    s.set_block_state( true );
+    s.notify( "f" );
+    assert_true( s.set_block_state( false ) );
+    assert_true( received == "adf" );
+    assert_true( count == 3 );
+
+    coalescing_subject< int, int > sum( []( std::tuple< int, int > &pending, std::tuple< int, int > &&latest )
+    {
+        std::get< 0 >( pending ) += std::get< 0 >( latest );
+        std::get< 1 >( pending )  = std::get< 1 >( latest );
+    } );
+    int total = 0;
+    int last  = 0;
+
+    auto c_sum = connect( sum, [ & ]( int i, int l ){ total += i; last = l; } );
+
+    sum.block();
+    for( int i = 1 ; i <= 1000 ; ++i )
+    {
+        sum.notify( i, i );
+    }
+    assert_true( total == 0 );
+    sum.unblock();
+    assert_true( total == 500500 );
+    assert_true( last == 1000 );
+
+    // Notifications while notifying the pending notification are deferred again when the observer blocks
+    coalescing_subject< int > reentrant;
+    std::vector< int > values;
+
+    auto c_reentrant = connect( reentrant, [ & ]( int i )
+    {
+        values.push_back( i );
+        if( i == 1 )
+        {
+            subject_blocker< coalescing_subject< int > > blocker( reentrant );
+            reentrant.notify( 2 );
+            reentrant.notify( 3 );
+        }
+    } );
+
+    reentrant.block();
+    reentrant.notify( 1 );
+    reentrant.unblock();
+    assert_true( values == std::vector< int >( { 1, 3 } ) );
+}
+
+template< typename S >
+static void block_connections()
+{
+    S s;
+    connection_owner owner;
+
+    std::string received;
+
+    const auto c1 = owner.connect( s, [ & ]( const std::string &v ){ received += "1" + v; } );
+    auto c2       = connect( s, [ & ]( const std::string &v ){ received += "2" + v; } );
+    const auto c3 = owner.connect( s, [ & ]( std::string v ){ received += "3" + v; } );
+
+    s.notify( "a" );
+    assert_true( received == "1a2a3a" );
+
+    // Blocked connections stay connected but are not notified
+    assert_true( !owner.set_block_state( c1, true ) );
+    assert_true( owner.set_block_state( c1, true ) );
+    assert_true( !c2.set_block_state( true ) );
+    received.clear();
+    s.notify( "b" );
+    assert_true( received == "3b" );
+
+    // Also when the last observer is blocked
+    assert_true( !owner.set_block_state( c3, true ) );
+    assert_true( c2.set_block_state( false ) );
+    received.clear();
+    s.notify( "c" );
+    assert_true( received == "2c" );
+
+    assert_true( owner.set_block_state( c1, false ) );
+    assert_true( owner.set_block_state( c3, false ) );
+    received.clear();
+    s.notify( "d" );
+    assert_true( received == "1d2d3d" );
+
+    // Blocking from within a notification
+    auto c4 = connect( s, [ & ]( const std::string & ){ owner.set_block_state( c1, true ); } );
+    received.clear();
+    s.notify( "e" );
+    s.notify( "f" );
+    assert_true( received == "1e2e3e2f3f" );
+
+    c4.reset();
+
+    // Disconnected connections can't be blocked
+    owner.disconnect( c1 );
+    assert_true( !owner.set_block_state( c1, true ) );
+    c2.reset();
+    assert_true( !c2.set_block_state( true ) );
+}
+
+static void block_connection_state()
+{
+    // The state of a callable that is stored in an inline_subject survives blocking
+    inline_subject<> s;
+    int count    = 0;
+    int * const p = &count;
+    auto c       = connect( s, [ p, n = 0 ]() mutable { *p = ++n; } );
+
+    s.notify();
+    s.notify();
+    assert_true( count == 2 );
+
+    c.set_block_state( true );
+    s.notify();
+    assert_true( count == 2 );
+
+    c.set_block_state( false );
+    s.notify();
+    assert_true( count == 3 );
+
+    // Blocked observers are skipped by batches
+    subject< int > s_batch;
+    int sum = 0;
+    auto c_batch = connect( s_batch, [ & ]( int i ){ sum += i; } );
+    c_batch.set_block_state( true );
+
+    const std::vector< subject< int >::event_type > events = { 1, 2 };
+    s_batch.notify_batch( events );
+    assert_true( sum == 0 );
+
+    // Subjects that don't support blocking observers
+    concurrent_subject< int > s_concurrent;
+    auto c_concurrent = connect( s_concurrent, [ & ]( int i ){ sum += i; } );
+    assert_true( !c_concurrent.set_block_state( true ) );
+    s_concurrent.notify( 1 );
+    assert_true( sum == 1 );
+}
+
+static void block_concurrent_subject()
+{
+    blockable_concurrent_subject< int > s;
+    std::atomic< int > sum{ 0 };
+    auto c = connect( s, [ & ]( int i ){ sum += i; } );
+
+    s.notify( 1 );
+    assert_true( sum == 1 );
+
+    {
+        subject_blocker< blockable_concurrent_subject< int > > blocker( s );
+        s.notify( 1 );
+        assert_true( sum == 1 );
+    }
+
+    assert_true( !s.set_block_state( true ) );
+    assert_true( s.set_block_state( true ) );
+    s.notify( 1 );
+    assert_true( s.set_block_state( false ) );
+    assert_true( !s.set_block_state( false ) );
+    s.notify( 1 );
+    assert_true( sum == 2 );
+
+    // Block and unblock from other threads while notifying
+    std::atomic< bool > done{ false };
+    std::thread blocker( [ & ]
+    {
+        while( !done )
+        {
+            s.block();
+            s.unblock();
+        }
+    } );
+
+    for( int i = 0 ; i < 10000 ; ++i )
+    {
+        s.notify( 1 );
+    }
+    done = true;
+    blocker.join();
+
+    s.unblock();
+    s.notify( 1 );
+    assert_true( sum > 2 && sum <= 10003 );
+}
+
 static void type_compatibility()
 {
     connection_owner               owner;
@@ -750,6 +3173,88 @@ static void invoke_function()
     assert_true( int_std_function == 42 );
 }
 
+struct copy_counter
+{
+    static int copies;
+    static int moves;
+
+    copy_counter() = default;
+
+    copy_counter( const copy_counter & )
+    {
+        ++copies;
+    }
+
+    copy_counter( copy_counter && ) noexcept
+    {
+        ++moves;
+    }
+
+    static void reset()
+    {
+        copies = 0;
+        moves  = 0;
+    }
+};
+
+int copy_counter::copies = 0;
+int copy_counter::moves  = 0;
+
+static void argument_copies()
+{
+    // Observers that take the value by const reference don't copy
+    {
+        subject< copy_counter > s;
+        connection_owner owner;
+        for( int i = 0 ; i < 3 ; ++i )
+        {
+            owner.connect( s, []( const copy_counter & ){} );
+        }
+
+        copy_counter::reset();
+        s.notify( copy_counter() );
+        assert_true( copy_counter::copies == 0 );
+    }
+
+    // The last observer receives rvalues that can be moved
+    {
+        subject< copy_counter > s;
+        connection_owner owner;
+        for( int i = 0 ; i < 3 ; ++i )
+        {
+            owner.connect( s, []( copy_counter ){} );
+        }
+
+        copy_counter::reset();
+        s.notify( copy_counter() );
+        assert_true( copy_counter::copies == 2 );
+
+        // Also when the last observer in the subject is disconnected
+        auto c = connect( s, []( copy_counter ){} );
+        c.reset();
+
+        copy_counter::reset();
+        s.notify( copy_counter() );
+        assert_true( copy_counter::copies == 2 );
+    }
+
+    // No copies at all with a subject that takes the values by const reference
+    {
+        const_ref_subject< copy_counter, int > s;
+        static_assert( std::is_base_of< detail::subject_base< const copy_counter &, int >, decltype( s ) >::value, "" );
+
+        int sum = 0;
+        auto c1 = connect( s, [ & ]( const copy_counter &, int v ){ sum += v; } );
+        auto c2 = connect( s, [ & ]( const copy_counter &, int v ){ sum += v; } );
+
+        const copy_counter value;
+        copy_counter::reset();
+        s.notify( value, 2 );
+        assert_true( copy_counter::copies == 0 && copy_counter::moves == 0 );
+        assert_true( sum == 4 );
+    }
+}
+
 struct object_forwarding
 {
     object_forwarding() = delete;
@@ -995,10 +3500,44 @@ int main( int /* argc */, char * /* argv */[] )
     scoped_observer();
     observer_disconnect();
     observer_notify_and_disconnect_order();
+    disconnect_keeps_order();
+    observer_notify_function();
+    inline_subject_observers();
+    reentrant_notify< subject< int > >();
+    reentrant_notify< blockable_subject< int > >();
+    reentrant_notify< inline_subject< int > >();
+    connection_owner_pool();
+    empty_subjects();
+    connection_owner_bulk();
+    connection_owner_teardown();
+    fixed_subjects();
+    erased_subjects();
+    recorded_subjects();
+    connection_handles();
+    concurrent_subject_observers();
+    queued_subject_observers();
+    parallel_notify();
+    batch_notify();
+    static_subject_observers();
+    priority_subject_observers();
+    collecting_subject_observers();
+    instrumented_subject_observers();
+    event_bus_topics();
+    channel_observers();
+    operator_pipelines();
+    awaitable_subjects();
     block_subject();
+    coalescing_subject_observers();
+    block_connections< subject< const std::string & > >();
+    block_connections< subject< std::string > >();
+    block_connections< blockable_subject< std::string > >();
+    block_connections< inline_subject< std::string > >();
+    block_connection_state();
+    block_concurrent_subject();
     type_compatibility();
     invoke_function();
     const_and_forwarding();
+    argument_copies();
     readme_examples();
 
     std::cout << "Total asserts: " << total_asserts << ", asserts failed: " << failed_asserts << std::endl;